@@ -31,4 +31,14 @@
  * Set this to 1 if you use high res sprites to define your 
  * collision shapes
  */
-#define GB2_HIGHRES_PHYSICS_SHAPES 1
\ No newline at end of file
+#define GB2_HIGHRES_PHYSICS_SHAPES 1
+
+/**
+ * Set this to 1 to compile the trace markers (GB2_TRACE_SCOPE)
+ * into the engine. Tracing must also be enabled at runtime
+ * with GB2Trace::setEnabled(true). With 0 the markers are
+ * removed completely.
+ */
+#ifndef GB2_TRACE
+#define GB2_TRACE 0
+#endif
@@ -66,5 +66,11 @@
  */
 -(void) setEnabled:(BOOL)enabled;
 
+/**
+ * Returns the number of GB2Contact objects currently alive
+ * Used for memory accounting
+ */
++(int) liveCount;
+
 @end
 
@@ -29,6 +29,9 @@
 #import "cocos2d.h"
 #import "GB2Node.h"
 
+// number of GB2Contact objects alive, contacts are only created on the main thread
+static int liveContacts = 0;
+
 @implementation GB2Contact
 
 @synthesize otherObject;
@@ -45,6 +48,7 @@
         ownFixture = myOwnFixture;
         otherFixture = theOtherFixture;
         box2dContact = theB2Contact;
+        liveContacts++;
     }
     return self;
 }
@@ -59,8 +63,14 @@
     box2dContact->SetEnabled(enabled);
 }
 
++(int) liveCount
+{
+    return liveContacts;
+}
+
 -(void) dealloc
 {
+    liveContacts--;
     [otherObject release];
     [super dealloc];
 }
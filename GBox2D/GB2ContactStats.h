@@ -0,0 +1,183 @@
+/*
+ MIT License
+ 
+ Copyright (c) 2010 Andreas Loew / www.code-and-web.de
+ 
+ For more information about htis module visit
+ http://www.PhysicsEditor.de
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+#import <map>
+#import <string>
+#import <vector>
+#import "Box2D.h"
+
+#pragma once
+
+/**
+ * Contact callbacks counted by GB2ContactStats
+ */
+enum GB2ContactEventType
+{
+    kGB2ContactBegin,
+    kGB2ContactEnd,
+    kGB2ContactPresolve,
+    kGB2ContactEventTypes
+};
+
+/**
+ * Sort orders for the hotspot lists
+ */
+enum GB2ContactSortOrder
+{
+    kGB2ContactSortByCount,         //!< all events
+    kGB2ContactSortByTime,          //!< dispatch time of all events
+    kGB2ContactSortByBegin,
+    kGB2ContactSortByEnd,
+    kGB2ContactSortByPresolve
+};
+
+/**
+ * Number of events and dispatch time per event type
+ */
+struct GB2ContactCounters
+{
+    int32 count[kGB2ContactEventTypes];
+    double time[kGB2ContactEventTypes];     //!< dispatch time in seconds
+    
+    void clear();
+    void add(const GB2ContactCounters &other);
+    void subtract(const GB2ContactCounters &other);
+    int32 totalCount() const;
+    double totalTime() const;
+    double value(GB2ContactSortOrder order) const;
+};
+
+/**
+ * Counters of a class pair or fixture id
+ */
+struct GB2ContactHotspot
+{
+    NSString *name;                 //!< "ClassA/ClassB" or the fixture id
+    GB2ContactCounters counters;
+};
+
+/**
+ * GB2ContactStats
+ *
+ * Counts the contact callbacks and their dispatch time per
+ * class pair and per fixture id
+ *
+ * The counters are aggregated per frame and over a rolling
+ * window of frames. Class pairs are unordered - Coin/Floor and
+ * Floor/Coin are the same pair. Each event is counted for the
+ * fixture ids of both fixtures.
+ */
+class GB2ContactStats
+{
+public:
+    /**
+     * @param windowFrames number of frames in the rolling window
+     */
+    GB2ContactStats(int32 windowFrames);
+    ~GB2ContactStats();
+    
+    /**
+     * Counts a contact callback
+     * @param type callback type
+     * @param contact the box2d contact
+     * @param time time spent dispatching the callback in seconds
+     */
+    void record(GB2ContactEventType type, b2Contact *contact, double time);
+    
+    /**
+     * Closes the current frame and moves it into the window
+     */
+    void endFrame();
+    
+    /**
+     * Drops all counters
+     */
+    void reset();
+    
+    /**
+     * Returns the counters of the last frame and the window
+     * @param classA class of the first object
+     * @param classB class of the second object
+     * @param frame receives the counters of the last frame, might be NULL
+     * @param window receives the counters of the window, might be NULL
+     * @return false if the pair had no contacts yet
+     */
+    bool countersForClassPair(Class classA, Class classB, GB2ContactCounters *frame, GB2ContactCounters *window) const;
+    
+    /**
+     * Returns the counters of a fixture id, nil for fixtures without id
+     */
+    bool countersForFixtureId(NSString *fixtureId, GB2ContactCounters *frame, GB2ContactCounters *window) const;
+    
+    /**
+     * Returns the counters of all events
+     */
+    void totals(GB2ContactCounters *frame, GB2ContactCounters *window) const;
+    
+    /**
+     * Returns the class pairs or fixture ids with the highest counters
+     * The names in the results are autoreleased.
+     * @param count maximum number of results
+     * @param order counter to sort by
+     * @param window true for the window, false for the last frame
+     */
+    std::vector<GB2ContactHotspot> topClassPairs(int count, GB2ContactSortOrder order, bool window) const;
+    std::vector<GB2ContactHotspot> topFixtureIds(int count, GB2ContactSortOrder order, bool window) const;
+    
+    /**
+     * Returns a readable table of the top class pairs and fixture ids
+     * with their share of the total
+     */
+    NSString *dump(int count, GB2ContactSortOrder order, bool window) const;
+    
+    int32 getWindowFrames() const { return windowFrames; }
+    
+private:
+    struct Entry
+    {
+        NSString *name;
+        GB2ContactCounters current;     // frame in progress
+        GB2ContactCounters frame;       // last complete frame
+        GB2ContactCounters window;
+        std::vector<GB2ContactCounters> history;
+    };
+    
+    Entry *classPairEntry(Class classA, Class classB);
+    Entry *fixtureIdEntry(void *userData);
+    Entry *newEntry(NSString *name);
+    std::vector<GB2ContactHotspot> top(const std::vector<Entry*> &entries, int count, GB2ContactSortOrder order, bool window) const;
+    
+    int32 windowFrames;
+    int32 historyIndex;
+    std::map<std::pair<Class, Class>, Entry*> classPairs;
+    std::map<void*, Entry*> fixtureIdsByPointer;       // user data pointer -> entry
+    std::map<std::string, Entry*> fixtureIdsByName;    // equal ids of different shapes share an entry
+    std::vector<Entry*> classPairEntries;
+    std::vector<Entry*> fixtureIdEntries;
+    Entry total;
+};
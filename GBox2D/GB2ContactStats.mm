@@ -0,0 +1,380 @@
+/*
+ MIT License
+ 
+ Copyright (c) 2010 Andreas Loew / www.code-and-web.de
+ 
+ For more information about htis module visit
+ http://www.PhysicsEditor.de
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import <algorithm>
+#import "GB2ContactStats.h"
+#import "GB2Node.h"
+
+void GB2ContactCounters::clear()
+{
+    for(int i=0; i<kGB2ContactEventTypes; i++)
+    {
+        count[i] = 0;
+        time[i] = 0.0;
+    }
+}
+
+void GB2ContactCounters::add(const GB2ContactCounters &other)
+{
+    for(int i=0; i<kGB2ContactEventTypes; i++)
+    {
+        count[i] += other.count[i];
+        time[i] += other.time[i];
+    }
+}
+
+void GB2ContactCounters::subtract(const GB2ContactCounters &other)
+{
+    for(int i=0; i<kGB2ContactEventTypes; i++)
+    {
+        count[i] -= other.count[i];
+        // rounding errors must not accumulate below zero
+        time[i] = MAX(0.0, time[i] - other.time[i]);
+    }
+}
+
+int32 GB2ContactCounters::totalCount() const
+{
+    return count[kGB2ContactBegin] + count[kGB2ContactEnd] + count[kGB2ContactPresolve];
+}
+
+double GB2ContactCounters::totalTime() const
+{
+    return time[kGB2ContactBegin] + time[kGB2ContactEnd] + time[kGB2ContactPresolve];
+}
+
+double GB2ContactCounters::value(GB2ContactSortOrder order) const
+{
+    switch(order)
+    {
+        case kGB2ContactSortByCount:    return totalCount();
+        case kGB2ContactSortByTime:     return totalTime();
+        case kGB2ContactSortByBegin:    return count[kGB2ContactBegin];
+        case kGB2ContactSortByEnd:      return count[kGB2ContactEnd];
+        case kGB2ContactSortByPresolve: return count[kGB2ContactPresolve];
+    }
+    return 0.0;
+}
+
+/**
+ * Sorts hotspots by descending value
+ */
+struct GB2HotspotCompare
+{
+    GB2HotspotCompare(GB2ContactSortOrder anOrder)
+    : order(anOrder)
+    {}
+    
+    bool operator()(const GB2ContactHotspot &a, const GB2ContactHotspot &b) const
+    {
+        return a.counters.value(order) > b.counters.value(order);
+    }
+    
+    GB2ContactSortOrder order;
+};
+
+GB2ContactStats::GB2ContactStats(int32 aWindowFrames)
+: windowFrames(MAX(1, aWindowFrames))
+, historyIndex(0)
+{
+    total.name = nil;
+    total.current.clear();
+    total.frame.clear();
+    total.window.clear();
+    total.history.resize(windowFrames);
+    reset();
+}
+
+GB2ContactStats::~GB2ContactStats()
+{
+    for(size_t i=0; i<classPairEntries.size(); i++)
+    {
+        [classPairEntries[i]->name release];
+        delete classPairEntries[i];
+    }
+    for(size_t i=0; i<fixtureIdEntries.size(); i++)
+    {
+        [fixtureIdEntries[i]->name release];
+        delete fixtureIdEntries[i];
+    }
+}
+
+GB2ContactStats::Entry *GB2ContactStats::newEntry(NSString *name)
+{
+    Entry *entry = new Entry();
+    entry->name = [name retain];
+    entry->current.clear();
+    entry->frame.clear();
+    entry->window.clear();
+    entry->history.resize(windowFrames);
+    for(int32 i=0; i<windowFrames; i++)
+    {
+        entry->history[i].clear();
+    }
+    return entry;
+}
+
+GB2ContactStats::Entry *GB2ContactStats::classPairEntry(Class classA, Class classB)
+{
+    // unordered pair
+    if(classB < classA)
+    {
+        std::swap(classA, classB);
+    }
+    
+    std::pair<Class, Class> key(classA, classB);
+    std::map<std::pair<Class, Class>, Entry*>::iterator it = classPairs.find(key);
+    if(it != classPairs.end())
+    {
+        return it->second;
+    }
+    
+    Entry *entry = newEntry([NSString stringWithFormat:@"%@/%@", NSStringFromClass(classA), NSStringFromClass(classB)]);
+    classPairs[key] = entry;
+    classPairEntries.push_back(entry);
+    return entry;
+}
+
+GB2ContactStats::Entry *GB2ContactStats::fixtureIdEntry(void *userData)
+{
+    std::map<void*, Entry*>::iterator it = fixtureIdsByPointer.find(userData);
+    if(it != fixtureIdsByPointer.end())
+    {
+        return it->second;
+    }
+    
+    // first event with this user data pointer - look up the id by name
+    NSString *fixtureId = userData ? (NSString*)userData : @"";
+    std::string name = [fixtureId UTF8String];
+    Entry *&entry = fixtureIdsByName[name];
+    if(!entry)
+    {
+        entry = newEntry(fixtureId);
+        fixtureIdEntries.push_back(entry);
+    }
+    fixtureIdsByPointer[userData] = entry;
+    return entry;
+}
+
+void GB2ContactStats::record(GB2ContactEventType type, b2Contact *contact, double time)
+{
+    b2Fixture *fixtureA = contact->GetFixtureA();
+    b2Fixture *fixtureB = contact->GetFixtureB();
+    GB2Node *a = (GB2Node *)fixtureA->GetBody()->GetUserData();
+    GB2Node *b = (GB2Node *)fixtureB->GetBody()->GetUserData();
+    
+    Entry *entries[4] = {
+        &total,
+        classPairEntry([a class], [b class]),
+        fixtureIdEntry(fixtureA->GetUserData()),
+        fixtureIdEntry(fixtureB->GetUserData())
+    };
+    
+    // a contact between two fixtures with the same id counts once
+    int numEntries = (entries[2] == entries[3]) ? 3 : 4;
+    for(int i=0; i<numEntries; i++)
+    {
+        entries[i]->current.count[type]++;
+        entries[i]->current.time[type] += time;
+    }
+}
+
+/**
+ * Moves the current frame of an entry into the window
+ */
+static void endEntryFrame(GB2ContactCounters &current, GB2ContactCounters &frame, GB2ContactCounters &window, GB2ContactCounters &oldest)
+{
+    window.subtract(oldest);
+    window.add(current);
+    oldest = current;
+    frame = current;
+    current.clear();
+}
+
+void GB2ContactStats::endFrame()
+{
+    endEntryFrame(total.current, total.frame, total.window, total.history[historyIndex]);
+    
+    for(size_t i=0; i<classPairEntries.size(); i++)
+    {
+        Entry *e = classPairEntries[i];
+        endEntryFrame(e->current, e->frame, e->window, e->history[historyIndex]);
+    }
+    for(size_t i=0; i<fixtureIdEntries.size(); i++)
+    {
+        Entry *e = fixtureIdEntries[i];
+        endEntryFrame(e->current, e->frame, e->window, e->history[historyIndex]);
+    }
+    
+    historyIndex = (historyIndex + 1) % windowFrames;
+}
+
+void GB2ContactStats::reset()
+{
+    std::vector<Entry*> *lists[2] = { &classPairEntries, &fixtureIdEntries };
+    for(int l=0; l<2; l++)
+    {
+        for(size_t i=0; i<lists[l]->size(); i++)
+        {
+            Entry *e = (*lists[l])[i];
+            e->current.clear();
+            e->frame.clear();
+            e->window.clear();
+            for(int32 j=0; j<windowFrames; j++)
+            {
+                e->history[j].clear();
+            }
+        }
+    }
+    
+    total.current.clear();
+    total.frame.clear();
+    total.window.clear();
+    for(int32 j=0; j<windowFrames; j++)
+    {
+        total.history[j].clear();
+    }
+    historyIndex = 0;
+}
+
+bool GB2ContactStats::countersForClassPair(Class classA, Class classB, GB2ContactCounters *frame, GB2ContactCounters *window) const
+{
+    if(classB < classA)
+    {
+        std::swap(classA, classB);
+    }
+    
+    std::map<std::pair<Class, Class>, Entry*>::const_iterator it = classPairs.find(std::make_pair(classA, classB));
+    if(it == classPairs.end())
+    {
+        return false;
+    }
+    if(frame)
+    {
+        *frame = it->second->frame;
+    }
+    if(window)
+    {
+        *window = it->second->window;
+    }
+    return true;
+}
+
+bool GB2ContactStats::countersForFixtureId(NSString *fixtureId, GB2ContactCounters *frame, GB2ContactCounters *window) const
+{
+    std::map<std::string, Entry*>::const_iterator it = fixtureIdsByName.find(fixtureId ? [fixtureId UTF8String] : "");
+    if(it == fixtureIdsByName.end())
+    {
+        return false;
+    }
+    if(frame)
+    {
+        *frame = it->second->frame;
+    }
+    if(window)
+    {
+        *window = it->second->window;
+    }
+    return true;
+}
+
+void GB2ContactStats::totals(GB2ContactCounters *frame, GB2ContactCounters *window) const
+{
+    if(frame)
+    {
+        *frame = total.frame;
+    }
+    if(window)
+    {
+        *window = total.window;
+    }
+}
+
+std::vector<GB2ContactHotspot> GB2ContactStats::top(const std::vector<Entry*> &entries, int count, GB2ContactSortOrder order, bool window) const
+{
+    std::vector<GB2ContactHotspot> result;
+    result.reserve(entries.size());
+    for(size_t i=0; i<entries.size(); i++)
+    {
+        GB2ContactHotspot hotspot;
+        hotspot.name = [[entries[i]->name retain] autorelease];
+        hotspot.counters = window ? entries[i]->window : entries[i]->frame;
+        if(hotspot.counters.value(order) > 0.0)
+        {
+            result.push_back(hotspot);
+        }
+    }
+    
+    size_t n = MIN((size_t)MAX(count, 0), result.size());
+    std::partial_sort(result.begin(), result.begin() + n, result.end(), GB2HotspotCompare(order));
+    result.resize(n);
+    return result;
+}
+
+std::vector<GB2ContactHotspot> GB2ContactStats::topClassPairs(int count, GB2ContactSortOrder order, bool window) const
+{
+    return top(classPairEntries, count, order, window);
+}
+
+std::vector<GB2ContactHotspot> GB2ContactStats::topFixtureIds(int count, GB2ContactSortOrder order, bool window) const
+{
+    return top(fixtureIdEntries, count, order, window);
+}
+
+/**
+ * Appends a table of hotspots
+ */
+static void appendHotspots(NSMutableString *text, NSString *title, const std::vector<GB2ContactHotspot> &hotspots, GB2ContactSortOrder order, double totalValue)
+{
+    [text appendFormat:@"%@\n", title];
+    for(size_t i=0; i<hotspots.size(); i++)
+    {
+        const GB2ContactCounters &c = hotspots[i].counters;
+        double share = (totalValue > 0.0) ? 100.0 * c.value(order) / totalValue : 0.0;
+        [text appendFormat:@"  %5.1f%%  %-32s begin %6d  end %6d  presolve %7d  time %8.3fms\n",
+            share, [hotspots[i].name UTF8String],
+            c.count[kGB2ContactBegin], c.count[kGB2ContactEnd], c.count[kGB2ContactPresolve],
+            c.totalTime() * 1000.0];
+    }
+}
+
+NSString *GB2ContactStats::dump(int count, GB2ContactSortOrder order, bool window) const
+{
+    const GB2ContactCounters &totalCounters = window ? total.window : total.frame;
+    
+    NSMutableString *text = [NSMutableString string];
+    [text appendFormat:@"Contacts (%@): begin %d  end %d  presolve %d  time %.3fms\n",
+        window ? [NSString stringWithFormat:@"last %d frames", windowFrames] : @"last frame",
+        totalCounters.count[kGB2ContactBegin], totalCounters.count[kGB2ContactEnd],
+        totalCounters.count[kGB2ContactPresolve], totalCounters.totalTime() * 1000.0];
+    
+    appendHotspots(text, @"Class pairs:", topClassPairs(count, order, window), order, totalCounters.value(order));
+    
+    // fixture ids are counted for both fixtures, the shares don't add up to 100%
+    appendHotspots(text, @"Fixture ids:", topFixtureIds(count, order, window), order, totalCounters.value(order));
+    return text;
+}
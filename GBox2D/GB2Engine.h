@@ -48,6 +48,52 @@ extern float PTM_RATIO;
  */
 typedef void(^GB2NodeCallBack)(GB2Node*);
 
+/**
+ * Result of a ray cast query
+ * node is nil if the ray did not hit anything, point and
+ * normal are zero and fraction is 1 in this case
+ */
+typedef struct
+{
+    GB2Node *node;          //!< the object that was hit
+    b2Fixture *fixture;     //!< the fixture that was hit
+    b2Vec2 point;           //!< hit point in physics coordinates
+    b2Vec2 normal;          //!< surface normal at the hit point
+    float32 fraction;       //!< fraction of the ray length at the hit point
+} GB2RayCastHit;
+
+/**
+ * Batch of ray casts, stored as structure of arrays
+ * All arrays must hold count elements. The optional
+ * output arrays may be NULL if the data is not needed.
+ * nodes[i] == nil means ray i missed, its point and
+ * normal are zero then.
+ */
+typedef struct
+{
+    int count;              //!< number of rays
+    const b2Vec2 *from;     //!< in: start points
+    const b2Vec2 *to;       //!< in: end points
+    GB2Node **nodes;        //!< out: closest object hit, nil if nothing was hit
+    b2Vec2 *points;         //!< out (optional): hit points, zero if nothing was hit
+    b2Vec2 *normals;        //!< out (optional): surface normals, zero if nothing was hit
+    float32 *fractions;     //!< out (optional): fraction of the ray length, 1 if nothing was hit
+} GB2RayCastBatch;
+
+/**
+ * Batch of AABB queries, stored as structure of arrays
+ * The objects found for query i are stored at
+ * results[i*maxResultsPerQuery] ... results[i*maxResultsPerQuery + resultCounts[i] - 1]
+ */
+typedef struct
+{
+    int count;                  //!< number of queries
+    const b2AABB *aabbs;        //!< in: boxes to query
+    int maxResultsPerQuery;     //!< number of result slots per query
+    GB2Node **results;          //!< out: count * maxResultsPerQuery objects
+    int *resultCounts;          //!< out: number of objects found per query
+} GB2AABBQueryBatch;
+
 /**
  * Convert b2Vec2 to CGPoint honoring PTM_RATIO
  */
@@ -69,7 +115,70 @@ inline CGPoint CGPointFromb2Vec2(const b2Vec2 &p)
     return CGPointMake(p.x * PTM_RATIO, p.y*PTM_RATIO);
 }
 
+/**
+ * Statistics of a bulk delete operation
+ */
+typedef struct
+{
+    int bodies;             //!< number of bodies destroyed
+    int fixtures;           //!< number of fixtures destroyed
+    int nodes;              //!< number of GB2Nodes deleted
+    double collectTime;     //!< seconds spent collecting the bodies
+    double destroyTime;     //!< seconds spent destroying bodies and nodes
+} GB2TeardownReport;
+
+/**
+ * Number and size of objects in a memory category
+ */
+typedef struct
+{
+    int count;          //!< number of objects
+    size_t bytes;       //!< estimated size in bytes
+} GB2MemoryItem;
+
+/**
+ * Memory used by the physics objects
+ * Sizes are estimated from the object sizes, the unused
+ * blocks in box2d's allocators are not included.
+ */
+typedef struct
+{
+    GB2MemoryItem shapeCache;   //!< cached fixture definitions and shapes
+    GB2MemoryItem bodies;       //!< box2d bodies
+    GB2MemoryItem fixtures;     //!< box2d fixtures incl. shapes, proxies and broadphase nodes
+    GB2MemoryItem contacts;     //!< box2d contacts
+    GB2MemoryItem nodes;        //!< GB2Node objects
+    GB2MemoryItem ccNodes;      //!< cocos2d nodes of the GB2Nodes (without textures)
+    GB2MemoryItem gb2Contacts;  //!< GB2Contact objects not yet released
+    size_t totalBytes;          //!< sum of all categories
+} GB2MemoryReport;
+
+/**
+ * Fixture counts of the physics level of detail in the last frame
+ */
+typedef struct
+{
+    int bodies;             //!< objects in the world
+    int coarseBodies;       //!< objects with a coarse level of detail
+    int fixtures;           //!< fixtures in the world
+    int fullFixtures;       //!< fixtures the world would have without level of detail
+    int swaps;              //!< fixture sets replaced in the frame
+} GB2LODStats;
+
+/**
+ * Type for block callbacks when the memory budget is exceeded
+ */
+typedef void(^GB2MemoryBudgetCallBack)(const GB2MemoryReport *report);
+
 class GB2WorldContactListener;
+class GB2SolverBudget;
+class GB2Simulation;
+class GB2ContactStats;
+class GB2NodeIndex;
+class GB2SensorOverlaps;
+class GB2TouchingCache;
+class GRandom;
+struct GB2SolverStats;
 
 /**
  * GB2Engine
@@ -77,11 +186,36 @@ class GB2WorldContactListener;
  * Wrapper for the Box2d simulation
  * Implemented as singleton to allow simple adding of new
  * objects
+ *
+ * The world and the fixed step loop are owned by a GB2Simulation,
+ * the engine steps it once per frame and updates the cocos2d nodes.
  */
 @interface GB2Engine : NSObject 
 {
     GB2WorldContactListener *worldContactListener;
+    GB2Simulation *simulation;
+    GB2NodeIndex *nodeIndex;
+    GB2SensorOverlaps *sensorOverlaps;
+    GB2TouchingCache *touchingCache;
     b2World* world;
+    GRandom *random;
+    BOOL autoBullet;
+    float autoBulletFraction;
+    BOOL autoSpriteBatching;
+    BOOL batchSensorContacts;
+    BOOL trackTouching;
+    int bulletBodyCount;
+    BOOL physicsLOD;
+    b2Vec2 lodCenter;
+    float lodHysteresis;
+    float lodDistances[kGB2ShapeLODLevels];
+    GB2LODStats lodStats;
+    GB2MemoryReport memoryHighWater;
+    size_t memoryBudget;
+    int memoryCheckInterval;
+    int framesToMemoryCheck;
+    BOOL memoryBudgetExceeded;
+    GB2MemoryBudgetCallBack memoryBudgetCallback;
 }
 
 /**
@@ -89,6 +223,113 @@ class GB2WorldContactListener;
  */
 @property (readonly, assign) b2World* world;
 
+/**
+ * Manage the bullet flag of dynamic objects automatically
+ * An object is set to bullet mode while it moves further
+ * than autoBulletFraction of its smallest fixture extent per
+ * step. Objects set with setBullet: are not managed.
+ */
+@property (nonatomic, assign) BOOL autoBullet;
+
+/**
+ * Fraction of the smallest fixture extent an object may move
+ * per step without bullet mode, default is 0.5
+ */
+@property (nonatomic, assign) float autoBulletFraction;
+
+/**
+ * Draw the sprites of GB2Nodes with shared CCSpriteBatchNodes
+ * With this enabled GB2Node's setParent: and setParent:z: add
+ * CCSprites to a CCSpriteBatchNode per texture and z order under
+ * the parent. Default is NO.
+ */
+@property (nonatomic, assign) BOOL autoSpriteBatching;
+
+/**
+ * Collect the contacts of sensor objects into overlap sets
+ * Objects with sensor fixtures implementing
+ *   -(void) sensorEntered:(NSArray*)entered exited:(NSArray*)exited;
+ * receive the objects entering and leaving once per step instead of
+ * the begin/end contact selectors. Contacts with these sensors don't
+ * call the selectors on the other object either. Enabling reports the
+ * objects already overlapping a sensor as entered. Default is NO.
+ */
+@property (nonatomic, assign) BOOL batchSensorContacts;
+
+/**
+ * Keep the touching state of the objects from the begin and end contacts
+ * Required by objectsTouching:, object:isTouchingClass: and
+ * object:isTouchingFixtureId: and the touching queries of GB2Node.
+ * Enabling adds the contacts which are already touching. Default is NO.
+ */
+@property (nonatomic, assign) BOOL trackTouching;
+
+/**
+ * Number of objects in bullet mode during the last frame
+ * Only counted if autoBullet is enabled
+ */
+@property (nonatomic, readonly) int bulletBodyCount;
+
+/**
+ * Select the level of detail of the physics shapes by distance
+ * Objects further than the distance of a level from lodCenter get
+ * coarser fixtures from the shape cache, see setLODDistance:forLevel:
+ * and GB2Node's setShapeLOD:. Disabling restores full detail.
+ * No fixtures are replaced while a journal is recorded. Default is NO.
+ */
+@property (nonatomic, assign) BOOL physicsLOD;
+
+/**
+ * Center of the level of detail in physics coordinates,
+ * usually the camera position
+ */
+@property (nonatomic, assign) b2Vec2 lodCenter;
+
+/**
+ * Distance an object has to come closer than the distance of its
+ * level before a finer level is used, default is 1
+ */
+@property (nonatomic, assign) float lodHysteresis;
+
+/**
+ * Fixture counts with and without level of detail in the last frame
+ * Only counted if physicsLOD is enabled
+ */
+@property (nonatomic, readonly) GB2LODStats lodStats;
+
+/**
+ * Sets the distance from which a level of detail is used
+ * Contacts of replaced fixtures end and begin again, the distances
+ * should be outside of the range where contacts matter.
+ * @param distance distance in physics coordinates, 0 disables the level
+ * @param level kGB2ShapeLODHull, kGB2ShapeLODBox or kGB2ShapeLODCircle
+ */
+-(void) setLODDistance:(float)distance forLevel:(GB2ShapeLOD)level;
+
+/**
+ * Returns the distance from which a level of detail is used
+ * @param level level of detail
+ * @return distance, 0 if the level is not used
+ */
+-(float) lodDistanceForLevel:(GB2ShapeLOD)level;
+
+/**
+ * Memory budget in bytes, 0 disables the budget check
+ * The check runs every memoryCheckInterval frames and calls
+ * memoryBudgetCallback once when the budget is exceeded
+ */
+@property (nonatomic, assign) size_t memoryBudget;
+
+/**
+ * Number of frames between two memory budget checks, default is 60
+ */
+@property (nonatomic, assign) int memoryCheckInterval;
+
+/**
+ * Called when the memory budget is exceeded
+ */
+@property (nonatomic, copy) GB2MemoryBudgetCallBack memoryBudgetCallback;
+
 /**
  * Returns the shared instance
  */
@@ -102,14 +343,325 @@ class GB2WorldContactListener;
 
 /**
  * Delete all objects
+ * The b2World and its allocators are kept so that
+ * they are warmed up for the next level. Use
+ * deleteAllObjectsWithBatchSize: to get the teardown statistics.
  */
 - (void)deleteAllObjects;
 
+/**
+ * Delete all objects in batches
+ * Contact callbacks are suppressed during the teardown - the
+ * objects don't receive endContact calls for the destroyed bodies.
+ * Each batch is wrapped in an autorelease pool.
+ * @param batchSize number of bodies to destroy per batch
+ * @return statistics and timing of the teardown
+ */
+- (GB2TeardownReport)deleteAllObjectsWithBatchSize:(int)batchSize;
+
 /**
  * Iterate all objects and performs the block with the object
  */
 - (void) iterateObjectsWithBlock:(GB2NodeCallBack)callback;
 
+/**
+ * Returns an object with the given tag, nil if there is none
+ * Uses the tag index. Tag 0 is not indexed.
+ * @param tag tag to look for
+ */
+- (GB2Node*) objectWithTag:(int)tag;
+
+/**
+ * Collects the objects with the given tag
+ * @param tag tag to look for, must not be 0
+ * @param results array receiving the objects
+ * @param maxResults size of the results array
+ * @return number of objects stored in results
+ */
+- (int) objectsWithTag:(int)tag results:(GB2Node**)results maxResults:(int)maxResults;
+
+/**
+ * Iterates the objects with the given tag
+ * The callback may destroy objects, destroyed objects are not
+ * visited. Objects created or tagged in the callback are not visited.
+ * @param tag tag to look for, must not be 0
+ * @param callback block to call
+ */
+- (void) iterateObjectsWithTag:(int)tag block:(GB2NodeCallBack)callback;
+
+/**
+ * Iterates the objects of the class and its subclasses
+ * Same rules as iterateObjectsWithTag:block:
+ * @param nodeClass class to look for
+ * @param callback block to call
+ */
+- (void) iterateObjectsOfClass:(Class)nodeClass block:(GB2NodeCallBack)callback;
+
+/**
+ * Returns the number of objects of the class and its subclasses
+ */
+- (int) countObjectsOfClass:(Class)nodeClass;
+
+/**
+ * Index maintenance, called by GB2Node
+ */
+- (void) addObjectToIndex:(GB2Node*)object;
+- (void) removeObjectFromIndex:(GB2Node*)object;
+- (void) object:(GB2Node*)object changedTagFrom:(int)oldTag;
+
+/**
+ * Collects the objects currently overlapping a sensor object
+ * Only available with batchSensorContacts enabled.
+ * @param sensor object with sensor fixtures
+ * @param results array receiving the objects
+ * @param maxResults size of the results array
+ * @return number of objects stored in results
+ */
+- (int) occupantsOfSensor:(GB2Node*)sensor results:(GB2Node**)results maxResults:(int)maxResults;
+
+/**
+ * Returns the number of objects overlapping a sensor object
+ */
+- (int) occupantCountOfSensor:(GB2Node*)sensor;
+
+/**
+ * Returns YES if the object overlaps the sensor object
+ */
+- (BOOL) sensor:(GB2Node*)sensor containsObject:(GB2Node*)object;
+
+/**
+ * Called by GB2Node when its body is destroyed
+ */
+- (void) removeObjectFromSensors:(GB2Node*)object;
+
+/**
+ * Collects the objects currently touching an object
+ * Only available with trackTouching enabled. The touching state is
+ * kept from the begin and end contacts, the query does not walk
+ * the contacts of the body.
+ * @param object object to get the touching objects for
+ * @param results array receiving the objects
+ * @param maxResults size of the results array
+ * @return number of objects stored in results
+ */
+- (int) objectsTouching:(GB2Node*)object results:(GB2Node**)results maxResults:(int)maxResults;
+
+/**
+ * Returns the objects currently touching an object
+ */
+- (NSArray*) objectsTouching:(GB2Node*)object;
+
+/**
+ * Returns YES if an object of the class or a subclass touches the object
+ */
+- (BOOL) object:(GB2Node*)object isTouchingClass:(Class)cls;
+
+/**
+ * Returns YES if a fixture of the object with the id touches another object
+ */
+- (BOOL) object:(GB2Node*)object isTouchingFixtureId:(NSString*)fixtureId;
+
+/**
+ * Called by GB2Node when its body is destroyed
+ */
+- (void) removeObjectFromTouching:(GB2Node*)object;
+
+/**
+ * Returns the world's random stream
+ * Use it for spawning etc. to get reproducible sequences
+ * together with the journal
+ */
+- (GRandom*) random;
+
+/**
+ * Reseeds the world's random stream
+ * @param seed seed value
+ */
+- (void) seedRandom:(uint32_t)seed;
+
+/**
+ * Adapts the solver iterations to keep the step time
+ * within the budget
+ * Use solverBudget to configure the iteration ranges.
+ * @param budget maximum time per step in ms
+ */
+- (void) enableAdaptiveSolverWithBudget:(float)budget;
+
+/**
+ * Goes back to the fixed solver iterations
+ */
+- (void) disableAdaptiveSolver;
+
+/**
+ * Returns the adaptive solver controller, NULL if disabled
+ */
+- (GB2SolverBudget*) solverBudget;
+
+/**
+ * Returns the current decisions of the adaptive solver
+ * @param stats receives the statistics
+ * @return NO if the adaptive solver is disabled
+ */
+- (BOOL) solverStats:(GB2SolverStats*)stats;
+
+/**
+ * Returns the portable simulation core running the world
+ */
+- (GB2Simulation*) simulation;
+
+/**
+ * Counts the contact callbacks and their dispatch time per
+ * class pair and fixture id
+ * @param frames number of frames in the rolling window
+ */
+- (void) enableContactStatsWithWindow:(int)frames;
+
+/**
+ * Stops counting the contact callbacks
+ */
+- (void) disableContactStats;
+
+/**
+ * Returns the contact statistics, NULL if disabled
+ */
+- (GB2ContactStats*) contactStats;
+
+/**
+ * Logs the class pairs and fixture ids with the most contact
+ * callbacks in the rolling window
+ * @param count number of entries per list
+ */
+- (void) logContactHotspots:(int)count;
+
+/**
+ * Returns the memory currently used by the physics objects
+ * Walks all bodies and fixtures - don't call it every frame.
+ * Updates the high water marks.
+ * @return memory report
+ */
+- (GB2MemoryReport) memoryReport;
+
+/**
+ * Returns the highest value seen in each category
+ * by memoryReport or the budget check
+ * @return memory report with the high water marks
+ */
+- (GB2MemoryReport) memoryHighWater;
+
+/**
+ * Writes the recorded trace events as Chrome trace event JSON
+ * Tracing must be compiled in with GB2_TRACE and enabled with
+ * GB2Trace::setEnabled(true). The file opens in Perfetto.
+ * @param path file to write
+ * @return YES if the file was written
+ */
+- (BOOL) writeTraceToFile:(NSString*)path;
+
+/**
+ * Starts recording a journal of all steps and all mutations
+ * applied through GB2Node objects
+ * The journal can be replayed with GB2JournalReplayer.
+ * Start it before creating the level objects for exact replays.
+ * @param hashInterval add a state hash every n steps, 0 for no hashes
+ */
+- (void) startJournalWithHashInterval:(int)hashInterval;
+
+/**
+ * Starts recording a journal with a size limit
+ * Once the journal reaches the limit it is restarted after the
+ * step with a snapshot of the existing objects. The journal then
+ * holds the steps since the last restart. Choose a limit well
+ * above the size of a snapshot.
+ * @param hashInterval add a state hash every n steps, 0 for no hashes
+ * @param sizeLimit size in bytes, 0 for no limit
+ */
+- (void) startJournalWithHashInterval:(int)hashInterval sizeLimit:(size_t)sizeLimit;
+
+/**
+ * Stops recording the journal
+ * @return the recorded journal data, nil if no journal was recorded
+ */
+- (NSData*) stopJournal;
+
+/**
+ * Collects all objects with a fixture overlapping the given box
+ * Uses the broadphase - fixtures are tested by their bounding box
+ * Each object is reported only once
+ * @param aabb box in physics coordinates
+ * @param categoryMask only fixtures sharing a category bit with the mask are reported
+ * @param results caller provided buffer for the objects
+ * @param maxResults size of the results buffer
+ * @return number of objects written to results
+ */
+- (int) queryAABB:(b2AABB)aabb categoryMask:(uint16)categoryMask results:(GB2Node**)results maxResults:(int)maxResults;
+
+/**
+ * Collects all objects containing the given point
+ * Each object is reported only once
+ * @param point point in physics coordinates
+ * @param categoryMask only fixtures sharing a category bit with the mask are reported
+ * @param results caller provided buffer for the objects
+ * @param maxResults size of the results buffer
+ * @return number of objects written to results
+ */
+- (int) queryPoint:(b2Vec2)point categoryMask:(uint16)categoryMask results:(GB2Node**)results maxResults:(int)maxResults;
+
+/**
+ * Casts a ray and returns the closest hit
+ * @param from start point in physics coordinates
+ * @param to end point in physics coordinates
+ * @param categoryMask only fixtures sharing a category bit with the mask are reported
+ * @param hit receives the closest hit, hit->node is nil if nothing was hit
+ * @return YES if something was hit
+ */
+- (BOOL) rayCastClosestFrom:(b2Vec2)from to:(b2Vec2)to categoryMask:(uint16)categoryMask hit:(GB2RayCastHit*)hit;
+
+/**
+ * Casts a ray and returns all fixtures hit along the ray
+ * The hits are not sorted
+ * @param from start point in physics coordinates
+ * @param to end point in physics coordinates
+ * @param categoryMask only fixtures sharing a category bit with the mask are reported
+ * @param hits caller provided buffer for the hits
+ * @param maxHits size of the hits buffer
+ * @return number of hits written to hits
+ */
+- (int) rayCastAllFrom:(b2Vec2)from to:(b2Vec2)to categoryMask:(uint16)categoryMask hits:(GB2RayCastHit*)hits maxHits:(int)maxHits;
+
+/**
+ * Casts a batch of rays and returns the closest hit for each of them
+ * E.g. for line of sight checks of many AI objects
+ * @param from array of start points
+ * @param to array of end points
+ * @param count number of rays
+ * @param categoryMask only fixtures sharing a category bit with the mask are reported
+ * @param hits caller provided buffer with count elements
+ * @return number of rays that hit something
+ */
+- (int) rayCastClosestBatchFrom:(const b2Vec2*)from to:(const b2Vec2*)to count:(int)count categoryMask:(uint16)categoryMask hits:(GB2RayCastHit*)hits;
+
+/**
+ * Casts a batch of rays on a pool of worker threads
+ * The queries only read the world - the call blocks until all
+ * rays are done, so the world is not stepped in the meantime.
+ * Don't create or destroy objects from other threads while
+ * the batch is running.
+ * @param batch rays to cast and arrays receiving the results
+ * @param categoryMask only fixtures sharing a category bit with the mask are reported
+ * @param threads number of threads to use, 0 uses one thread per cpu core
+ * @return number of rays that hit something
+ */
+- (int) rayCastBatch:(GB2RayCastBatch*)batch categoryMask:(uint16)categoryMask threads:(int)threads;
+
+/**
+ * Runs a batch of AABB queries on a pool of worker threads
+ * Same restrictions as rayCastBatch:categoryMask:threads:
+ * @param batch boxes to query and arrays receiving the results
+ * @param categoryMask only fixtures sharing a category bit with the mask are reported
+ * @param threads number of threads to use, 0 uses one thread per cpu core
+ */
+- (void) queryAABBBatch:(GB2AABBQueryBatch*)batch categoryMask:(uint16)categoryMask threads:(int)threads;
+
 @end
 
 
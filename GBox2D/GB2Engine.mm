@@ -25,22 +25,274 @@
  THE SOFTWARE.
  */
 
+#import <QuartzCore/QuartzCore.h>
+#import <objc/runtime.h>
+#import <vector>
 #import "Box2D.h"
 #import "GB2Contact.h"
 #import "GB2Engine.h"
 #import "GB2WorldContactListener.h"
+#import "GB2Journal.h"
+#import "GB2SolverBudget.h"
+#import "GB2Simulation.h"
+#import "GB2ContactStats.h"
+#import "GB2NodeIndex.h"
+#import "GB2SensorOverlaps.h"
+#import "GB2TouchingCache.h"
+#import "GMath.h"
+#import "GB2Trace.h"
 
 // default ptm ratio value
 float PTM_RATIO = 32.0f;
 
+// number of bodies destroyed per autorelease pool in deleteAllObjects
+static const int kGB2TeardownBatchSize = 256;
+
+/**
+ * Returns the object owning the fixture if the fixture
+ * passes the category mask, nil otherwise
+ */
+static inline GB2Node *queryNodeForFixture(b2Fixture *fixture, uint16 categoryMask)
+{
+    if(!(fixture->GetFilterData().categoryBits & categoryMask))
+    {
+        return nil;
+    }
+    return (GB2Node*)fixture->GetBody()->GetUserData();
+}
+
+/**
+ * Internal class to collect the objects overlapping an AABB
+ * or containing a point
+ */
+class GB2NodeQueryCallback : public b2QueryCallback
+{
+public:
+    GB2NodeQueryCallback(uint16 aCategoryMask, GB2Node **aResults, int aMaxResults, const b2Vec2 *aPoint)
+    : categoryMask(aCategoryMask)
+    , results(aResults)
+    , maxResults(aMaxResults)
+    , count(0)
+    , point(aPoint)
+    {}
+    
+    bool ReportFixture(b2Fixture* fixture)
+    {
+        GB2Node *node = queryNodeForFixture(fixture, categoryMask);
+        if(!node || (point && !fixture->TestPoint(*point)))
+        {
+            return true;
+        }
+        
+        // objects with multiple fixtures are reported only once
+        for(int i=0; i<count; i++)
+        {
+            if(results[i] == node)
+            {
+                return true;
+            }
+        }
+        
+        results[count++] = node;
+        
+        // stop the query if the buffer is full
+        return count < maxResults;
+    }
+    
+    uint16 categoryMask;
+    GB2Node **results;
+    int maxResults;
+    int count;
+    const b2Vec2 *point;
+};
+
+/**
+ * Internal class to find the closest hit of a ray
+ */
+class GB2ClosestRayCastCallback : public b2RayCastCallback
+{
+public:
+    GB2ClosestRayCastCallback(uint16 aCategoryMask, GB2RayCastHit *aHit)
+    : categoryMask(aCategoryMask)
+    , hit(aHit)
+    {
+        // a miss leaves no data of an earlier ray behind
+        hit->node = nil;
+        hit->fixture = 0;
+        hit->point.SetZero();
+        hit->normal.SetZero();
+        hit->fraction = 1.0f;
+    }
+    
+    float32 ReportFixture(b2Fixture* fixture, const b2Vec2& point, const b2Vec2& normal, float32 fraction)
+    {
+        GB2Node *node = queryNodeForFixture(fixture, categoryMask);
+        if(!node)
+        {
+            // filter the fixture
+            return -1.0f;
+        }
+        
+        hit->node = node;
+        hit->fixture = fixture;
+        hit->point = point;
+        hit->normal = normal;
+        hit->fraction = fraction;
+        
+        // clip the ray to the hit
+        return fraction;
+    }
+    
+    uint16 categoryMask;
+    GB2RayCastHit *hit;
+};
+
+/**
+ * Internal class to collect all hits of a ray
+ */
+class GB2AllRayCastCallback : public b2RayCastCallback
+{
+public:
+    GB2AllRayCastCallback(uint16 aCategoryMask, GB2RayCastHit *aHits, int aMaxHits)
+    : categoryMask(aCategoryMask)
+    , hits(aHits)
+    , maxHits(aMaxHits)
+    , count(0)
+    {}
+    
+    float32 ReportFixture(b2Fixture* fixture, const b2Vec2& point, const b2Vec2& normal, float32 fraction)
+    {
+        GB2Node *node = queryNodeForFixture(fixture, categoryMask);
+        if(!node)
+        {
+            return -1.0f;
+        }
+        
+        GB2RayCastHit &hit = hits[count++];
+        hit.node = node;
+        hit.fixture = fixture;
+        hit.point = point;
+        hit.normal = normal;
+        hit.fraction = fraction;
+        
+        // continue without clipping until the buffer is full
+        return (count < maxHits) ? 1.0f : 0.0f;
+    }
+    
+    uint16 categoryMask;
+    GB2RayCastHit *hits;
+    int maxHits;
+    int count;
+};
+
+/**
+ * Casts a single ray and stores the closest hit
+ * Only reads the world, safe to call from worker threads
+ */
+static bool rayCastClosest(const b2World *world, const b2Vec2 &from, const b2Vec2 &to, uint16 categoryMask, GB2RayCastHit *hit)
+{
+    GB2ClosestRayCastCallback callback(categoryMask, hit);
+    if((to - from).LengthSquared() > 0.0f)
+    {
+        world->RayCast(&callback, from, to);
+    }
+    return hit->node != nil;
+}
+
+/**
+ * Runs the block over count items split into chunks
+ * Chunks are processed in parallel on the global dispatch queue
+ * dispatch_apply returns after all chunks are done
+ */
+static void runChunked(int count, int threads, void(^chunkBlock)(int begin, int end))
+{
+    if(threads <= 0)
+    {
+        threads = (int)[[NSProcessInfo processInfo] activeProcessorCount];
+    }
+    int numChunks = MIN(MAX(threads, 1), MAX(count, 1));
+    
+    if(numChunks == 1)
+    {
+        chunkBlock(0, count);
+        return;
+    }
+    
+    int chunkSize = (count + numChunks - 1) / numChunks;
+    dispatch_apply(numChunks, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0), ^(size_t chunk) {
+        int begin = (int)chunk * chunkSize;
+        int end = MIN(begin + chunkSize, count);
+        if(begin < end)
+        {
+            chunkBlock(begin, end);
+        }
+    });
+}
+
+/**
+ * Records the existing objects into the journal - oldest first
+ * so that the replayed body list has the same order
+ */
+static void recordJournalSnapshot(b2World *world)
+{
+    std::vector<GB2Node*> nodes;
+    for (b2Body* b = world->GetBodyList(); b; b = b->GetNext())
+    {
+        GB2Node *o = (GB2Node*)(b->GetUserData());
+        if(o)
+        {
+            nodes.push_back(o);
+        }
+    }
+    for(size_t i=nodes.size(); i>0; i--)
+    {
+        [nodes[i-1] recordJournalSnapshot];
+    }
+}
+
+/**
+ * Records the velocities set by the kinematic controller in the
+ * journal, the replay has no controller
+ */
+static void journalKinematicVelocities(const GB2KinematicController *kinematics)
+{
+    const std::vector<b2Body*> &finishedBodies = kinematics->getFinishedBodies();
+    int32 moverCount = kinematics->getMoverCount();
+    for(int32 i=0; i<moverCount + (int32)finishedBodies.size(); i++)
+    {
+        b2Body *b = (i < moverCount) ? kinematics->getMoverBody(i) : finishedBodies[i - moverCount];
+        GB2Node *o = (GB2Node*)(b->GetUserData());
+        if(o)
+        {
+            gb2Journal->recordVec2Op(kGB2JournalLinearVelocity, [o nodeId], b->GetLinearVelocity());
+            gb2Journal->recordFloatOp(kGB2JournalAngularVelocity, [o nodeId], b->GetAngularVelocity());
+        }
+    }
+}
+
 @interface GB2Engine (private_selectors)
 - (id)init;
 - (void)step:(ccTime)dt;
+- (void)syncObjectsWithTimeStep:(float32)timeStep;
+- (void)updateShapeLOD;
 @end
 
 @implementation GB2Engine
 
 @synthesize world;
+@synthesize autoBullet;
+@synthesize autoBulletFraction;
+@synthesize autoSpriteBatching;
+@synthesize batchSensorContacts;
+@synthesize trackTouching;
+@synthesize bulletBodyCount;
+@synthesize physicsLOD;
+@synthesize lodCenter;
+@synthesize lodHysteresis;
+@synthesize lodStats;
+@synthesize memoryBudget;
+@synthesize memoryCheckInterval;
+@synthesize memoryBudgetCallback;
 
 + (GB2Engine*)sharedInstance
 {
@@ -60,9 +312,21 @@ float PTM_RATIO = 32.0f;
     {
         // set default gravity
         b2Vec2 gravity(0.0f, -10.0f);
-        bool doSleep = true;    
-        world = new b2World(gravity);
-        world->SetAllowSleeping(doSleep);
+        simulation = new GB2Simulation(gravity);
+        world = simulation->getWorld();
+        nodeIndex = new GB2NodeIndex();
+        sensorOverlaps = new GB2SensorOverlaps();
+        touchingCache = new GB2TouchingCache();
+        
+        // contacts are dispatched immediately by the contact listener
+        simulation->setRecordContactEvents(false);
+        
+        // random stream of the world
+        random = new GRandom();
+        
+        autoBulletFraction = 0.5f;
+        lodHysteresis = 1.0f;
+        memoryCheckInterval = 60;
         
         // get ptmRatio from GB2ShapeCache
         if(GB2_HIGHRES_PHYSICS_SHAPES)
@@ -76,7 +340,7 @@ float PTM_RATIO = 32.0f;
         
         // set the contact listener
         worldContactListener = new GB2WorldContactListener();
-        world->SetContactListener(worldContactListener);    
+        simulation->setContactListener(worldContactListener);
         
         // schedule update
         [[CCDirector sharedDirector].scheduler scheduleUpdateForTarget:self priority:0 paused:NO];
@@ -86,21 +350,80 @@ float PTM_RATIO = 32.0f;
 
 - (void)deleteAllObjects
 {
-    // iterate all bodies
+    [self deleteAllObjectsWithBatchSize:kGB2TeardownBatchSize];
+}
+
+- (GB2TeardownReport)deleteAllObjectsWithBatchSize:(int)batchSize
+{
+    GB2TeardownReport report = {0, 0, 0, 0.0, 0.0};
+    if(batchSize <= 0)
+    {
+        batchSize = kGB2TeardownBatchSize;
+    }
+    
+    CFTimeInterval startTime = CACurrentMediaTime();
+    
+    // collect all objects first - destroying a body while walking
+    // the body list would read the next pointer of a destroyed body.
+    // The objects are retained, a deleteNow override might delete
+    // other objects before their turn.
+    std::vector<GB2Node*> nodes;
+    std::vector<b2Body*> bodies;
+    nodes.reserve(world->GetBodyCount());
     for (b2Body* b = world->GetBodyList(); b; b = b->GetNext()) 
-    {        
+    {
         GB2Node *o = (GB2Node*)(b->GetUserData());
         if(o)
         {
-            // destroy physics object
-            [o deleteNow];        
+            nodes.push_back([o retain]);
         }
         else
         {
-            // destroy body
-            world->DestroyBody(b);
+            bodies.push_back(b);
+        }
+        for (b2Fixture *f = b->GetFixtureList(); f; f = f->GetNext())
+        {
+            report.fixtures++;
+        }
+    }
+    report.bodies = (int)(nodes.size() + bodies.size());
+    
+    CFTimeInterval collectTime = CACurrentMediaTime();
+    report.collectTime = collectTime - startTime;
+    
+    // suppress endContact callbacks into objects being torn down
+    simulation->setContactListener(NULL);
+    simulation->getKinematics()->clear();
+    nodeIndex->clear();
+    sensorOverlaps->clear();
+    touchingCache->clear();
+    
+    // bodies without an object run no code when they are destroyed
+    for (size_t i = 0; i < bodies.size(); i++)
+    {
+        world->DestroyBody(bodies[i]);
+    }
+    
+    // the body list starts with the newest body - the cocos2d nodes
+    // are removed from the end of their parent's child list this way.
+    // deleteNow does nothing for objects which are already deleted.
+    for (size_t batchStart = 0; batchStart < nodes.size(); batchStart += batchSize)
+    {
+        size_t batchEnd = MIN(batchStart + batchSize, nodes.size());
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+        for (size_t i = batchStart; i < batchEnd; i++)
+        {
+            [nodes[i] deleteNow];
+            [nodes[i] release];
+            report.nodes++;
         }
+        [pool drain];
     }
+    
+    simulation->setContactListener(worldContactListener);
+    
+    report.destroyTime = CACurrentMediaTime() - collectTime;
+    return report;
 }
 
 - (void)deleteWorld 
@@ -109,9 +432,22 @@ float PTM_RATIO = 32.0f;
     [self deleteAllObjects];
     
     // delete the world
-	delete world;
+	delete simulation;
+	simulation = NULL;
 	world = NULL;
     
+    delete nodeIndex;
+    nodeIndex = NULL;
+    
+    delete sensorOverlaps;
+    sensorOverlaps = NULL;
+    
+    delete touchingCache;
+    touchingCache = NULL;
+    
+    delete random;
+    random = NULL;
+    
     // delete the contact listener
     delete worldContactListener;
     worldContactListener = NULL;
@@ -120,33 +456,674 @@ float PTM_RATIO = 32.0f;
 
 - (void)update:(ccTime)dt 
 {            
-    const float32 timeStep = 1.0f / 30.0f;
-    const int32 velocityIterations = 5;
-    const int32 positionIterations = 1;
-    
     // step the world
-	world->Step(timeStep, velocityIterations, positionIterations);
+    simulation->step();
+    
+    if(gb2Journal)
+    {
+        journalKinematicVelocities(simulation->getKinematics());
+        gb2Journal->recordStep(simulation->getTimeStep(),
+                               simulation->getLastVelocityIterations(),
+                               simulation->getLastPositionIterations(),
+                               world);
+        
+        // start a new segment from the current state
+        if(gb2Journal->full())
+        {
+            gb2Journal->restart();
+            recordJournalSnapshot(world);
+        }
+    }
+
+    // kinematic motions which ended in this step
+    const std::vector<b2Body*> &finishedBodies = simulation->getKinematics()->getFinishedBodies();
+    for(size_t i=0; i<finishedBodies.size(); i++)
+    {
+        // bodies destroyed by an earlier callback are NULL
+        if(!finishedBodies[i])
+        {
+            continue;
+        }
+        GB2Node *o = (GB2Node*)(finishedBodies[i]->GetUserData());
+        if([o respondsToSelector:@selector(kinematicMotionFinished)])
+        {
+            [o performSelector:@selector(kinematicMotionFinished)];
+        }
+    }
 
+    // batched enter/exit events of the sensors
+    sensorOverlaps->dispatch();
+    
+    // update the cocos2d nodes from the bodies
+    [self syncObjectsWithTimeStep:simulation->getTimeStep()];
+    
+    if(physicsLOD)
+    {
+        [self updateShapeLOD];
+    }
+    
+    GB2ContactStats *contactStats = worldContactListener->getStats();
+    if(contactStats)
+    {
+        contactStats->endFrame();
+    }
+    
+    if(memoryBudget && --framesToMemoryCheck <= 0)
+    {
+        framesToMemoryCheck = memoryCheckInterval;
+        GB2MemoryReport report = [self memoryReport];
+        
+        // report only once until the usage drops below the budget
+        BOOL exceeded = report.totalBytes > memoryBudget;
+        if(exceeded && !memoryBudgetExceeded && memoryBudgetCallback)
+        {
+            memoryBudgetCallback(&report);
+        }
+        memoryBudgetExceeded = exceeded;
+    }
+}
+
+- (void)syncObjectsWithTimeStep:(float32)timeStep
+{
+    GB2_TRACE_SCOPE("GB2Engine::syncObjects");
+    
+    __block int bullets = 0;
+    BOOL manageBullets = autoBullet;
+    float bulletFraction = autoBulletFraction;
+    
     [self iterateObjectsWithBlock:^(GB2Node *o) {
         // update position, rotation
         [o updateCCFromPhysics];
         
+        // the new velocity decides about bullet mode in the next step
+        if(manageBullets && [o updateBulletForTimeStep:timeStep fraction:bulletFraction])
+        {
+            bullets++;
+        }
+        
         if(o.deleteLater)
         {
             // destroys the body and removes the object from the scene
             [o deleteNow];
         }
     }];
+    
+    bulletBodyCount = bullets;
+}
+
+- (void)updateShapeLOD
+{
+    GB2_TRACE_SCOPE("GB2Engine::updateShapeLOD");
+    
+    GB2LODStats stats = { 0, 0, 0, 0, 0 };
+    for(b2Body *b = world->GetBodyList(); b; b = b->GetNext())
+    {
+        GB2Node *o = (GB2Node*)(b->GetUserData());
+        if([o updateShapeLODWithCenter:lodCenter distances:lodDistances hysteresis:lodHysteresis])
+        {
+            stats.swaps++;
+        }
+        
+        int fixtures = 0;
+        for(b2Fixture *f = b->GetFixtureList(); f; f = f->GetNext())
+        {
+            fixtures++;
+        }
+        
+        stats.bodies++;
+        stats.fixtures += fixtures;
+        stats.fullFixtures += fixtures + [o fixturesSavedByLOD];
+        if([o shapeLOD] != kGB2ShapeLODFull)
+        {
+            stats.coarseBodies++;
+        }
+    }
+    lodStats = stats;
+}
+
+- (void) setPhysicsLOD:(BOOL)enabled
+{
+    physicsLOD = enabled;
+    
+    if(!enabled)
+    {
+        [self iterateObjectsWithBlock:^(GB2Node *o) {
+            [o setShapeLOD:kGB2ShapeLODFull];
+        }];
+        memset(&lodStats, 0, sizeof(lodStats));
+    }
+}
+
+- (void) setLODDistance:(float)distance forLevel:(GB2ShapeLOD)level
+{
+    NSAssert(level > kGB2ShapeLODFull && level < kGB2ShapeLODLevels, @"Invalid level of detail");
+    lodDistances[level] = MAX(distance, 0.0f);
+}
+
+- (float) lodDistanceForLevel:(GB2ShapeLOD)level
+{
+    return lodDistances[level];
 }
 
 - (void) iterateObjectsWithBlock:(GB2NodeCallBack)callback
 {
-	for (b2Body* b = world->GetBodyList(); b; b = b->GetNext()) 
+	b2Body* next;
+	for (b2Body* b = world->GetBodyList(); b; b = next) 
     {        
+        // the callback might destroy the body
+        next = b->GetNext();
+        
         // get the object
         callback((GB2Node*)(b->GetUserData()));
     }    
 }
 
+/**
+ * Calls the block for a copy of index lists
+ * The index lists can't be iterated directly - removing an object
+ * moves the last object of the list into its place. Objects
+ * destroyed by the callback are skipped.
+ */
+static void iterateIndexList(GB2NodeIndex *index, const GB2NodeList &snapshot, GB2NodeCallBack callback)
+{
+    index->beginIteration();
+    for(size_t i = snapshot.size(); i > 0; i--)
+    {
+        GB2Node *node = snapshot[i-1];
+        if(!index->removedDuringIteration(node))
+        {
+            callback(node);
+        }
+    }
+    index->endIteration();
+}
+
+- (GB2Node*) objectWithTag:(int)tag
+{
+    const GB2NodeList *nodes = nodeIndex->nodesWithTag(tag);
+    return (nodes && !nodes->empty()) ? nodes->back() : nil;
+}
+
+- (int) objectsWithTag:(int)tag results:(GB2Node**)results maxResults:(int)maxResults
+{
+    const GB2NodeList *nodes = nodeIndex->nodesWithTag(tag);
+    int count = nodes ? MIN(maxResults, (int)nodes->size()) : 0;
+    for(int i=0; i<count; i++)
+    {
+        results[i] = (*nodes)[nodes->size() - 1 - i];
+    }
+    return MAX(count, 0);
+}
+
+- (void) iterateObjectsWithTag:(int)tag block:(GB2NodeCallBack)callback
+{
+    const GB2NodeList *nodes = nodeIndex->nodesWithTag(tag);
+    if(nodes)
+    {
+        iterateIndexList(nodeIndex, GB2NodeList(*nodes), callback);
+    }
+}
+
+- (void) iterateObjectsOfClass:(Class)nodeClass block:(GB2NodeCallBack)callback
+{
+    // collect the buckets first, the callback might add buckets
+    GB2NodeList nodes;
+    const std::map<Class, GB2NodeList> &buckets = nodeIndex->classBuckets();
+    for(std::map<Class, GB2NodeList>::const_iterator it = buckets.begin(); it != buckets.end(); ++it)
+    {
+        if([it->first isSubclassOfClass:nodeClass])
+        {
+            nodes.insert(nodes.end(), it->second.begin(), it->second.end());
+        }
+    }
+    iterateIndexList(nodeIndex, nodes, callback);
+}
+
+- (int) countObjectsOfClass:(Class)nodeClass
+{
+    int count = 0;
+    const std::map<Class, GB2NodeList> &buckets = nodeIndex->classBuckets();
+    for(std::map<Class, GB2NodeList>::const_iterator it = buckets.begin(); it != buckets.end(); ++it)
+    {
+        if([it->first isSubclassOfClass:nodeClass])
+        {
+            count += (int)it->second.size();
+        }
+    }
+    return count;
+}
+
+- (void) addObjectToIndex:(GB2Node*)object
+{
+    nodeIndex->add(object, [object class], [object objectTag]);
+}
+
+- (void) removeObjectFromIndex:(GB2Node*)object
+{
+    nodeIndex->remove(object, [object class], [object objectTag]);
+}
+
+- (void) object:(GB2Node*)object changedTagFrom:(int)oldTag
+{
+    nodeIndex->changeTag(object, oldTag, [object objectTag]);
+}
+
+- (void) setBatchSensorContacts:(BOOL)enabled
+{
+    batchSensorContacts = enabled;
+    
+    sensorOverlaps->clear();
+    if(enabled)
+    {
+        sensorOverlaps->addTouchingContacts(world);
+    }
+    worldContactListener->setSensorOverlaps(enabled ? sensorOverlaps : NULL);
+}
+
+- (int) occupantsOfSensor:(GB2Node*)sensor results:(GB2Node**)results maxResults:(int)maxResults
+{
+    const std::vector<GB2SensorOccupant> *occupants = sensorOverlaps->occupants(sensor);
+    int count = occupants ? MIN(maxResults, (int)occupants->size()) : 0;
+    for(int i=0; i<count; i++)
+    {
+        results[i] = (*occupants)[i].node;
+    }
+    return MAX(count, 0);
+}
+
+- (int) occupantCountOfSensor:(GB2Node*)sensor
+{
+    const std::vector<GB2SensorOccupant> *occupants = sensorOverlaps->occupants(sensor);
+    return occupants ? (int)occupants->size() : 0;
+}
+
+- (BOOL) sensor:(GB2Node*)sensor containsObject:(GB2Node*)object
+{
+    const std::vector<GB2SensorOccupant> *occupants = sensorOverlaps->occupants(sensor);
+    if(occupants)
+    {
+        for(size_t i=0; i<occupants->size(); i++)
+        {
+            if((*occupants)[i].node == object)
+            {
+                return YES;
+            }
+        }
+    }
+    return NO;
+}
+
+- (void) removeObjectFromSensors:(GB2Node*)object
+{
+    sensorOverlaps->removeNode(object);
+}
+
+- (void) setTrackTouching:(BOOL)enabled
+{
+    trackTouching = enabled;
+    
+    touchingCache->clear();
+    if(enabled)
+    {
+        touchingCache->addTouchingContacts(world);
+    }
+    worldContactListener->setTouchingCache(enabled ? touchingCache : NULL);
+}
+
+- (int) objectsTouching:(GB2Node*)object results:(GB2Node**)results maxResults:(int)maxResults
+{
+    const std::vector<GB2TouchingNode> *nodes = touchingCache->touchingNodes(object);
+    int count = nodes ? MIN(maxResults, (int)nodes->size()) : 0;
+    for(int i=0; i<count; i++)
+    {
+        results[i] = (*nodes)[i].node;
+    }
+    return MAX(count, 0);
+}
+
+- (NSArray*) objectsTouching:(GB2Node*)object
+{
+    const std::vector<GB2TouchingNode> *nodes = touchingCache->touchingNodes(object);
+    if(!nodes)
+    {
+        return [NSArray array];
+    }
+    
+    NSMutableArray *result = [NSMutableArray arrayWithCapacity:nodes->size()];
+    for(size_t i=0; i<nodes->size(); i++)
+    {
+        [result addObject:(*nodes)[i].node];
+    }
+    return result;
+}
+
+- (BOOL) object:(GB2Node*)object isTouchingClass:(Class)cls
+{
+    return touchingCache->isTouchingClass(object, cls);
+}
+
+- (BOOL) object:(GB2Node*)object isTouchingFixtureId:(NSString*)fixtureId
+{
+    return touchingCache->isTouchingFixtureId(object, fixtureId);
+}
+
+- (void) removeObjectFromTouching:(GB2Node*)object
+{
+    touchingCache->removeNode(object);
+}
+
+- (GRandom*) random
+{
+    return random;
+}
+
+- (void) seedRandom:(uint32_t)seed
+{
+    random->setSeed(seed);
+}
+
+- (void) enableAdaptiveSolverWithBudget:(float)budget
+{
+    simulation->enableSolverBudget(budget);
+}
+
+- (void) disableAdaptiveSolver
+{
+    simulation->disableSolverBudget();
+}
+
+- (GB2SolverBudget*) solverBudget
+{
+    return simulation->getSolverBudget();
+}
+
+- (BOOL) solverStats:(GB2SolverStats*)stats
+{
+    GB2SolverBudget *solverBudget = simulation->getSolverBudget();
+    if(!solverBudget)
+    {
+        return NO;
+    }
+    *stats = solverBudget->getStats();
+    return YES;
+}
+
+- (GB2Simulation*) simulation
+{
+    return simulation;
+}
+
+- (void) enableContactStatsWithWindow:(int)frames
+{
+    worldContactListener->enableStats(frames);
+}
+
+- (void) disableContactStats
+{
+    worldContactListener->disableStats();
+}
+
+- (GB2ContactStats*) contactStats
+{
+    return worldContactListener->getStats();
+}
+
+- (void) logContactHotspots:(int)count
+{
+    GB2ContactStats *contactStats = worldContactListener->getStats();
+    if(contactStats)
+    {
+        CCLOG(@"%@", contactStats->dump(count, kGB2ContactSortByCount, true));
+    }
+}
+
+/**
+ * Returns the size of a box2d shape including allocated vertices
+ */
+static size_t shapeMemoryUsage(const b2Shape *shape)
+{
+    switch(shape->GetType())
+    {
+        case b2Shape::e_circle:
+            return sizeof(b2CircleShape);
+        case b2Shape::e_edge:
+            return sizeof(b2EdgeShape);
+        case b2Shape::e_polygon:
+            return sizeof(b2PolygonShape);
+        case b2Shape::e_chain:
+            return sizeof(b2ChainShape) + ((const b2ChainShape*)shape)->GetVertexCount() * sizeof(b2Vec2);
+        default:
+            return 0;
+    }
+}
+
+static inline void addMemory(GB2MemoryItem &item, int count, size_t bytes)
+{
+    item.count += count;
+    item.bytes += bytes;
+}
+
+static inline void updateHighWater(GB2MemoryItem &highWater, const GB2MemoryItem &item)
+{
+    highWater.count = MAX(highWater.count, item.count);
+    highWater.bytes = MAX(highWater.bytes, item.bytes);
+}
+
+- (GB2MemoryReport) memoryReport
+{
+    GB2MemoryReport report;
+    memset(&report, 0, sizeof(report));
+    
+    report.shapeCache.bytes = [[GB2ShapeCache sharedShapeCache] memoryUsage:&report.shapeCache.count];
+    
+    for (b2Body* b = world->GetBodyList(); b; b = b->GetNext())
+    {
+        addMemory(report.bodies, 1, sizeof(b2Body));
+        
+        for (b2Fixture *f = b->GetFixtureList(); f; f = f->GetNext())
+        {
+            // each child has a proxy and a leaf in the dynamic tree
+            // the tree has about the same number of inner nodes
+            int32 children = f->GetShape()->GetChildCount();
+            addMemory(report.fixtures, 1, sizeof(b2Fixture)
+                      + shapeMemoryUsage(f->GetShape())
+                      + children * (sizeof(b2FixtureProxy) + 2 * sizeof(b2TreeNode)));
+        }
+        
+        GB2Node *o = (GB2Node*)(b->GetUserData());
+        if(o)
+        {
+            addMemory(report.nodes, 1, class_getInstanceSize([o class]));
+            if(o.ccNode)
+            {
+                addMemory(report.ccNodes, 1, class_getInstanceSize([o.ccNode class]));
+            }
+        }
+    }
+    
+    // all contact types have the size of the base class
+    addMemory(report.contacts, world->GetContactCount(), world->GetContactCount() * sizeof(b2Contact));
+    
+    int liveContacts = [GB2Contact liveCount];
+    addMemory(report.gb2Contacts, liveContacts, liveContacts * class_getInstanceSize([GB2Contact class]));
+    
+    report.totalBytes = report.shapeCache.bytes + report.bodies.bytes + report.fixtures.bytes
+                      + report.contacts.bytes + report.nodes.bytes + report.ccNodes.bytes
+                      + report.gb2Contacts.bytes;
+    
+    updateHighWater(memoryHighWater.shapeCache, report.shapeCache);
+    updateHighWater(memoryHighWater.bodies, report.bodies);
+    updateHighWater(memoryHighWater.fixtures, report.fixtures);
+    updateHighWater(memoryHighWater.contacts, report.contacts);
+    updateHighWater(memoryHighWater.nodes, report.nodes);
+    updateHighWater(memoryHighWater.ccNodes, report.ccNodes);
+    updateHighWater(memoryHighWater.gb2Contacts, report.gb2Contacts);
+    memoryHighWater.totalBytes = MAX(memoryHighWater.totalBytes, report.totalBytes);
+    
+    return report;
+}
+
+- (GB2MemoryReport) memoryHighWater
+{
+    return memoryHighWater;
+}
+
+- (BOOL) writeTraceToFile:(NSString*)path
+{
+    std::string json = GB2Trace::exportJSON();
+    NSData *data = [NSData dataWithBytes:json.data() length:json.size()];
+    return [data writeToFile:path atomically:YES];
+}
+
+- (void) startJournalWithHashInterval:(int)hashInterval
+{
+    [self startJournalWithHashInterval:hashInterval sizeLimit:0];
+}
+
+- (void) startJournalWithHashInterval:(int)hashInterval sizeLimit:(size_t)sizeLimit
+{
+    delete gb2Journal;
+    gb2Journal = new GB2Journal(hashInterval, sizeLimit);
+    recordJournalSnapshot(world);
+}
+
+- (NSData*) stopJournal
+{
+    if(!gb2Journal)
+    {
+        return nil;
+    }
+    
+    const std::vector<uint8> &journalData = gb2Journal->data();
+    NSData *data = [NSData dataWithBytes:(journalData.empty() ? 0 : &journalData[0]) length:journalData.size()];
+    
+    delete gb2Journal;
+    gb2Journal = 0;
+    
+    return data;
+}
+
+- (int) queryAABB:(b2AABB)aabb categoryMask:(uint16)categoryMask results:(GB2Node**)results maxResults:(int)maxResults
+{
+    if(maxResults <= 0)
+    {
+        return 0;
+    }
+    
+    GB2NodeQueryCallback callback(categoryMask, results, maxResults, 0);
+    world->QueryAABB(&callback, aabb);
+    return callback.count;
+}
+
+- (int) queryPoint:(b2Vec2)point categoryMask:(uint16)categoryMask results:(GB2Node**)results maxResults:(int)maxResults
+{
+    if(maxResults <= 0)
+    {
+        return 0;
+    }
+    
+    // query a tiny box around the point and test the fixtures
+    b2AABB aabb;
+    b2Vec2 d(b2_linearSlop, b2_linearSlop);
+    aabb.lowerBound = point - d;
+    aabb.upperBound = point + d;
+    
+    GB2NodeQueryCallback callback(categoryMask, results, maxResults, &point);
+    world->QueryAABB(&callback, aabb);
+    return callback.count;
+}
+
+- (BOOL) rayCastClosestFrom:(b2Vec2)from to:(b2Vec2)to categoryMask:(uint16)categoryMask hit:(GB2RayCastHit*)hit
+{
+    return rayCastClosest(world, from, to, categoryMask, hit);
+}
+
+- (int) rayCastAllFrom:(b2Vec2)from to:(b2Vec2)to categoryMask:(uint16)categoryMask hits:(GB2RayCastHit*)hits maxHits:(int)maxHits
+{
+    if((maxHits <= 0) || ((to - from).LengthSquared() <= 0.0f))
+    {
+        return 0;
+    }
+    
+    GB2AllRayCastCallback callback(categoryMask, hits, maxHits);
+    world->RayCast(&callback, from, to);
+    return callback.count;
+}
+
+- (int) rayCastClosestBatchFrom:(const b2Vec2*)from to:(const b2Vec2*)to count:(int)count categoryMask:(uint16)categoryMask hits:(GB2RayCastHit*)hits
+{
+    int numHits = 0;
+    for(int i=0; i<count; i++)
+    {
+        if(rayCastClosest(world, from[i], to[i], categoryMask, &hits[i]))
+        {
+            numHits++;
+        }
+    }
+    return numHits;
+}
+
+- (int) rayCastBatch:(GB2RayCastBatch*)batch categoryMask:(uint16)categoryMask threads:(int)threads
+{
+    assert(!world->IsLocked());
+    
+    const b2World *w = world;
+    runChunked(batch->count, threads, ^(int begin, int end) {
+        GB2RayCastHit hit;
+        for(int i=begin; i<end; i++)
+        {
+            rayCastClosest(w, batch->from[i], batch->to[i], categoryMask, &hit);
+            
+            // scatter into the output arrays
+            batch->nodes[i] = hit.node;
+            if(batch->points)
+            {
+                batch->points[i] = hit.point;
+            }
+            if(batch->normals)
+            {
+                batch->normals[i] = hit.normal;
+            }
+            if(batch->fractions)
+            {
+                batch->fractions[i] = hit.fraction;
+            }
+        }
+    });
+    
+    // count after all chunks are done, no shared counter needed
+    int numHits = 0;
+    for(int i=0; i<batch->count; i++)
+    {
+        if(batch->nodes[i])
+        {
+            numHits++;
+        }
+    }
+    return numHits;
+}
+
+- (void) queryAABBBatch:(GB2AABBQueryBatch*)batch categoryMask:(uint16)categoryMask threads:(int)threads
+{
+    assert(!world->IsLocked());
+    
+    const b2World *w = world;
+    int maxResults = batch->maxResultsPerQuery;
+    
+    runChunked(batch->count, threads, ^(int begin, int end) {
+        for(int i=begin; i<end; i++)
+        {
+            int count = 0;
+            if(maxResults > 0)
+            {
+                GB2NodeQueryCallback callback(categoryMask, batch->results + i*maxResults, maxResults, 0);
+                w->QueryAABB(&callback, batch->aabbs[i]);
+                count = callback.count;
+            }
+            batch->resultCounts[i] = count;
+        }
+    });
+}
+
 
 @end
\ No newline at end of file
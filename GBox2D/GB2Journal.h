@@ -0,0 +1,240 @@
+/*
+ MIT License
+ 
+ Copyright (c) 2010 Andreas Loew / www.code-and-web.de
+ 
+ For more information about htis module visit
+ http://www.PhysicsEditor.de
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import <vector>
+#import <map>
+#import "Box2D.h"
+
+#pragma once
+
+class GB2Journal;
+
+/**
+ * The active journal, NULL if no journal is recorded
+ * Same reasoning as for PTM_RATIO: GB2Node checks this on
+ * every mutation, asking GB2Engine would be too slow.
+ */
+extern GB2Journal *gb2Journal;
+
+/**
+ * Operations stored in the journal
+ */
+enum GB2JournalOp
+{
+    kGB2JournalStep = 1,            //!< dt, velocity iterations, position iterations
+    kGB2JournalStepHash,            //!< as step, followed by the state hash
+    kGB2JournalCreate,              //!< id, body type
+    kGB2JournalDestroy,             //!< id
+    kGB2JournalShape,               //!< id, shape name, scale
+    kGB2JournalEdge,                //!< id, start, end
+    kGB2JournalBodyType,            //!< id, body type
+    kGB2JournalLinearImpulse,       //!< id, impulse, point
+    kGB2JournalForce,               //!< id, force, point
+    kGB2JournalTransform,           //!< id, position, angle
+    kGB2JournalLinearVelocity,      //!< id, velocity
+    kGB2JournalAngularVelocity,     //!< id, velocity
+    kGB2JournalActive,              //!< id, flag
+    kGB2JournalBullet,              //!< id, flag
+    kGB2JournalFixedRotation,       //!< id, flag
+    kGB2JournalLinearDamping,       //!< id, damping
+    kGB2JournalAngularDamping,      //!< id, damping
+    kGB2JournalFilterBits,          //!< id, filter op, bits, fixture id
+    kGB2JournalFixture,             //!< id, shape, density, friction, restitution, sensor, filter, fixture id
+    kGB2JournalAwake,               //!< id, flag
+    kGB2JournalSleepingAllowed,     //!< id, flag
+};
+
+/**
+ * Collision filter changes stored in kGB2JournalFilterBits
+ */
+enum GB2JournalFilterOp
+{
+    kGB2JournalSetMask = 0,
+    kGB2JournalAddMask,
+    kGB2JournalClrMask,
+    kGB2JournalSetCategory,
+    kGB2JournalAddCategory,
+    kGB2JournalClrCategory,
+};
+
+/**
+ * Computes a hash over the position, angle and velocity
+ * of the bodies in the world
+ * @param world the world
+ * @param onlyNodes only hash bodies owned by a GB2Node
+ */
+uint32 GB2JournalHashWorld(const b2World *world, bool onlyNodes);
+
+/**
+ * GB2Journal
+ *
+ * Compact binary recording of the world steps and all
+ * mutations applied through GB2Node
+ *
+ * Each record is an op byte followed by the node id as
+ * variable length integer and the raw payload. A step costs
+ * 7 bytes, 11 bytes if it contains a state hash.
+ *
+ * The journal should be started before the level objects are
+ * created. Objects existing at the start are recorded with their
+ * fixtures, transform, velocity and sleep state - their contacts
+ * are not part of the journal.
+ *
+ * Fixtures added with addFixture: are recorded with their raw
+ * definition. Their user data must be a fixture id (NSString) or NULL.
+ *
+ * Not recorded: contacts disabled in the presolve callbacks and
+ * bodies not owned by a GB2Node.
+ *
+ * With a size limit the owner restarts the journal once it is full
+ * and records a snapshot of the objects, see restart().
+ */
+class GB2Journal
+{
+public:
+    /**
+     * @param hashInterval add a state hash every n steps, 0 for no hashes
+     * @param sizeLimit size in bytes after which full() returns true, 0 for no limit
+     */
+    GB2Journal(int32 hashInterval, size_t sizeLimit = 0);
+    
+    void recordStep(float32 dt, int32 velocityIterations, int32 positionIterations, const b2World *world);
+    void recordCreate(uint32 nodeId, b2BodyType bodyType);
+    void recordDestroy(uint32 nodeId);
+    void recordShape(uint32 nodeId, const char *shapeName, float32 scale);
+    void recordEdge(uint32 nodeId, const b2Vec2 &start, const b2Vec2 &end);
+    void recordBodyType(uint32 nodeId, b2BodyType bodyType);
+    void recordVec2Op(GB2JournalOp op, uint32 nodeId, const b2Vec2 &v);
+    void recordVec2PairOp(GB2JournalOp op, uint32 nodeId, const b2Vec2 &v1, const b2Vec2 &v2);
+    void recordTransform(uint32 nodeId, const b2Vec2 &pos, float32 angle);
+    void recordFloatOp(GB2JournalOp op, uint32 nodeId, float32 value);
+    void recordFlagOp(GB2JournalOp op, uint32 nodeId, bool flag);
+    void recordFilterBits(uint32 nodeId, GB2JournalFilterOp filterOp, uint16 bits, const char *fixtureId);
+    
+    /**
+     * Records a fixture with its shape, material, sensor flag and filter
+     * @param fixtureId fixture id stored as user data, might be NULL
+     */
+    void recordFixture(uint32 nodeId, const b2FixtureDef &fixtureDef, const char *fixtureId);
+    
+    /**
+     * Returns true if the size limit is reached
+     */
+    bool full() const { return sizeLimit && buffer.size() >= sizeLimit; }
+    
+    /**
+     * Drops the recorded data, keeps the memory
+     * The next records must be a snapshot of the existing objects.
+     */
+    void restart();
+    
+    /**
+     * Returns the recorded data
+     */
+    const std::vector<uint8> &data() const { return buffer; }
+    
+    /**
+     * Returns the number of recorded steps
+     */
+    int32 stepCount() const { return steps; }
+    
+private:
+    void writeU8(uint8 v) { buffer.push_back(v); }
+    void writeVarint(uint32 v);
+    void writeU32(uint32 v);
+    void writeFloat(float32 v);
+    void writeString(const char *s);
+    void writeOp(GB2JournalOp op, uint32 nodeId);
+    void writeVec2(const b2Vec2 &v) { writeFloat(v.x); writeFloat(v.y); }
+    
+    std::vector<uint8> buffer;
+    size_t sizeLimit;
+    int32 hashInterval;
+    int32 steps;
+};
+
+/**
+ * GB2JournalReplayer
+ *
+ * Replays a journal into an empty world without cocos2d and
+ * compares the state hashes after each step. The shapes used
+ * in the journal must be loaded into the GB2ShapeCache.
+ *
+ * Journals from the field might be truncated or corrupt, the
+ * replay stops at the first record which can't be read.
+ */
+class GB2JournalReplayer
+{
+public:
+    GB2JournalReplayer(const uint8 *data, size_t size);
+    ~GB2JournalReplayer();
+    
+    /**
+     * Replays the journal
+     * @param world empty world to replay into
+     * @return true if the journal was replayed without divergence
+     *         and without errors
+     */
+    bool run(b2World *world);
+    
+    /**
+     * Returns the offset of the first record which can't be read,
+     * -1 if the journal was read completely
+     */
+    long errorOffset() const { return firstErrorOffset; }
+    
+    /**
+     * Returns the number of replayed steps
+     */
+    int32 stepCount() const { return steps; }
+    
+    /**
+     * Returns the step with the first hash mismatch, -1 if none
+     */
+    int32 divergentStep() const { return firstDivergentStep; }
+    
+private:
+    uint8 readU8();
+    uint32 readVarint();
+    uint32 readU32();
+    float32 readFloat();
+    b2Vec2 readVec2();
+    const char *readString(std::vector<char> &storage);
+    bool truncated() const { return pos > size; }
+    
+    void applyFilterBits(b2Body *body, GB2JournalFilterOp filterOp, uint16 bits, const char *fixtureId);
+    bool createFixture(b2Body *body, std::vector<char> &stringStorage);
+    
+    const uint8 *data;
+    size_t size;
+    size_t pos;
+    int32 steps;
+    int32 firstDivergentStep;
+    long firstErrorOffset;
+    std::map<uint32, b2Body*> bodies;
+    std::vector<void*> fixtureIds;  // NSStrings used as fixture user data, retained
+};
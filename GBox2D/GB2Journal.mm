@@ -0,0 +1,659 @@
+/*
+ MIT License
+ 
+ Copyright (c) 2010 Andreas Loew / www.code-and-web.de
+ 
+ For more information about htis module visit
+ http://www.PhysicsEditor.de
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import <string.h>
+#import "GB2Journal.h"
+#import "GB2ShapeCache.h"
+
+// the active journal
+GB2Journal *gb2Journal = 0;
+
+uint32 GB2JournalHashWorld(const b2World *world, bool onlyNodes)
+{
+    // FNV-1a over the raw bits of the body state
+    uint32 hash = 2166136261u;
+    for(const b2Body *b = world->GetBodyList(); b; b = b->GetNext())
+    {
+        if(onlyNodes && !b->GetUserData())
+        {
+            continue;
+        }
+        
+        float32 state[6] = {
+            b->GetPosition().x, b->GetPosition().y, b->GetAngle(),
+            b->GetLinearVelocity().x, b->GetLinearVelocity().y, b->GetAngularVelocity()
+        };
+        const uint8 *bytes = (const uint8*)state;
+        for(size_t i=0; i<sizeof(state); i++)
+        {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+    }
+    return hash;
+}
+
+GB2Journal::GB2Journal(int32 aHashInterval, size_t aSizeLimit)
+: sizeLimit(aSizeLimit)
+, hashInterval(aHashInterval)
+, steps(0)
+{
+    size_t initialSize = 64 * 1024;
+    buffer.reserve(sizeLimit ? b2Min(sizeLimit, initialSize) : initialSize);
+}
+
+void GB2Journal::restart()
+{
+    buffer.clear();
+    steps = 0;
+}
+
+void GB2Journal::writeVarint(uint32 v)
+{
+    while(v >= 0x80)
+    {
+        buffer.push_back((uint8)(v | 0x80));
+        v >>= 7;
+    }
+    buffer.push_back((uint8)v);
+}
+
+void GB2Journal::writeU32(uint32 v)
+{
+    uint8 bytes[sizeof(uint32)];
+    memcpy(bytes, &v, sizeof(uint32));
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(uint32));
+}
+
+void GB2Journal::writeFloat(float32 v)
+{
+    uint8 bytes[sizeof(float32)];
+    memcpy(bytes, &v, sizeof(float32));
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(float32));
+}
+
+void GB2Journal::writeString(const char *s)
+{
+    uint32 length = s ? (uint32)strlen(s) : 0;
+    writeVarint(length);
+    buffer.insert(buffer.end(), (const uint8*)s, (const uint8*)s + length);
+}
+
+void GB2Journal::writeOp(GB2JournalOp op, uint32 nodeId)
+{
+    writeU8((uint8)op);
+    writeVarint(nodeId);
+}
+
+void GB2Journal::recordStep(float32 dt, int32 velocityIterations, int32 positionIterations, const b2World *world)
+{
+    steps++;
+    bool withHash = (hashInterval > 0) && (steps % hashInterval == 0);
+    writeU8(withHash ? kGB2JournalStepHash : kGB2JournalStep);
+    writeFloat(dt);
+    writeU8((uint8)velocityIterations);
+    writeU8((uint8)positionIterations);
+    if(withHash)
+    {
+        writeU32(GB2JournalHashWorld(world, true));
+    }
+}
+
+void GB2Journal::recordCreate(uint32 nodeId, b2BodyType bodyType)
+{
+    writeOp(kGB2JournalCreate, nodeId);
+    writeU8((uint8)bodyType);
+}
+
+void GB2Journal::recordDestroy(uint32 nodeId)
+{
+    writeOp(kGB2JournalDestroy, nodeId);
+}
+
+void GB2Journal::recordShape(uint32 nodeId, const char *shapeName, float32 scale)
+{
+    writeOp(kGB2JournalShape, nodeId);
+    writeString(shapeName);
+    writeFloat(scale);
+}
+
+void GB2Journal::recordEdge(uint32 nodeId, const b2Vec2 &start, const b2Vec2 &end)
+{
+    recordVec2PairOp(kGB2JournalEdge, nodeId, start, end);
+}
+
+void GB2Journal::recordBodyType(uint32 nodeId, b2BodyType bodyType)
+{
+    writeOp(kGB2JournalBodyType, nodeId);
+    writeU8((uint8)bodyType);
+}
+
+void GB2Journal::recordVec2Op(GB2JournalOp op, uint32 nodeId, const b2Vec2 &v)
+{
+    writeOp(op, nodeId);
+    writeFloat(v.x);
+    writeFloat(v.y);
+}
+
+void GB2Journal::recordVec2PairOp(GB2JournalOp op, uint32 nodeId, const b2Vec2 &v1, const b2Vec2 &v2)
+{
+    writeOp(op, nodeId);
+    writeFloat(v1.x);
+    writeFloat(v1.y);
+    writeFloat(v2.x);
+    writeFloat(v2.y);
+}
+
+void GB2Journal::recordTransform(uint32 nodeId, const b2Vec2 &pos, float32 angle)
+{
+    writeOp(kGB2JournalTransform, nodeId);
+    writeFloat(pos.x);
+    writeFloat(pos.y);
+    writeFloat(angle);
+}
+
+void GB2Journal::recordFloatOp(GB2JournalOp op, uint32 nodeId, float32 value)
+{
+    writeOp(op, nodeId);
+    writeFloat(value);
+}
+
+void GB2Journal::recordFlagOp(GB2JournalOp op, uint32 nodeId, bool flag)
+{
+    writeOp(op, nodeId);
+    writeU8(flag ? 1 : 0);
+}
+
+void GB2Journal::recordFilterBits(uint32 nodeId, GB2JournalFilterOp filterOp, uint16 bits, const char *fixtureId)
+{
+    writeOp(kGB2JournalFilterBits, nodeId);
+    writeU8((uint8)filterOp);
+    writeVarint(bits);
+    writeString(fixtureId);
+}
+
+void GB2Journal::recordFixture(uint32 nodeId, const b2FixtureDef &fixtureDef, const char *fixtureId)
+{
+    const b2Shape *shape = fixtureDef.shape;
+    if(shape->GetType() >= b2Shape::e_typeCount)
+    {
+        // no shape type of this Box2D version - not replayable
+        return;
+    }
+    
+    writeOp(kGB2JournalFixture, nodeId);
+    writeU8((uint8)shape->GetType());
+    
+    switch(shape->GetType())
+    {
+        case b2Shape::e_circle:
+        {
+            const b2CircleShape *circle = (const b2CircleShape*)shape;
+            writeFloat(circle->m_radius);
+            writeVec2(circle->m_p);
+            break;
+        }
+        case b2Shape::e_edge:
+        {
+            const b2EdgeShape *edge = (const b2EdgeShape*)shape;
+            writeVec2(edge->m_vertex1);
+            writeVec2(edge->m_vertex2);
+            writeU8((edge->m_hasVertex0 ? 1 : 0) | (edge->m_hasVertex3 ? 2 : 0));
+            writeVec2(edge->m_vertex0);
+            writeVec2(edge->m_vertex3);
+            break;
+        }
+        case b2Shape::e_polygon:
+        {
+            const b2PolygonShape *polygon = (const b2PolygonShape*)shape;
+            writeU8((uint8)polygon->GetVertexCount());
+            for(int32 i=0; i<polygon->GetVertexCount(); i++)
+            {
+                writeVec2(polygon->GetVertex(i));
+            }
+            break;
+        }
+        case b2Shape::e_chain:
+        {
+            const b2ChainShape *chain = (const b2ChainShape*)shape;
+            writeVarint((uint32)chain->m_count);
+            for(int32 i=0; i<chain->m_count; i++)
+            {
+                writeVec2(chain->m_vertices[i]);
+            }
+            writeU8((chain->m_hasPrevVertex ? 1 : 0) | (chain->m_hasNextVertex ? 2 : 0));
+            writeVec2(chain->m_prevVertex);
+            writeVec2(chain->m_nextVertex);
+            break;
+        }
+        default:
+            break;
+    }
+    
+    writeFloat(fixtureDef.density);
+    writeFloat(fixtureDef.friction);
+    writeFloat(fixtureDef.restitution);
+    writeU8(fixtureDef.isSensor ? 1 : 0);
+    writeVarint(fixtureDef.filter.categoryBits);
+    writeVarint(fixtureDef.filter.maskBits);
+    writeVarint((uint16)fixtureDef.filter.groupIndex);
+    writeString(fixtureId);
+}
+
+
+GB2JournalReplayer::GB2JournalReplayer(const uint8 *aData, size_t aSize)
+: data(aData)
+, size(aSize)
+, pos(0)
+, steps(0)
+, firstDivergentStep(-1)
+, firstErrorOffset(-1)
+{
+}
+
+GB2JournalReplayer::~GB2JournalReplayer()
+{
+    for(size_t i=0; i<fixtureIds.size(); i++)
+    {
+        [(NSString*)fixtureIds[i] release];
+    }
+}
+
+uint8 GB2JournalReplayer::readU8()
+{
+    // reading past the end marks the journal as truncated
+    uint8 v = (pos < size) ? data[pos] : 0;
+    pos++;
+    return v;
+}
+
+uint32 GB2JournalReplayer::readVarint()
+{
+    uint32 v = 0;
+    for(int shift = 0; shift < 35; shift += 7)
+    {
+        uint8 b = readU8();
+        v |= (uint32)(b & 0x7f) << shift;
+        if(!(b & 0x80))
+        {
+            break;
+        }
+    }
+    return v;
+}
+
+uint32 GB2JournalReplayer::readU32()
+{
+    uint32 v = 0;
+    if(pos + sizeof(uint32) <= size)
+    {
+        memcpy(&v, data + pos, sizeof(uint32));
+    }
+    pos += sizeof(uint32);
+    return v;
+}
+
+float32 GB2JournalReplayer::readFloat()
+{
+    float32 v = 0.0f;
+    if(pos + sizeof(float32) <= size)
+    {
+        memcpy(&v, data + pos, sizeof(float32));
+    }
+    pos += sizeof(float32);
+    return v;
+}
+
+b2Vec2 GB2JournalReplayer::readVec2()
+{
+    float32 x = readFloat();
+    float32 y = readFloat();
+    return b2Vec2(x, y);
+}
+
+const char *GB2JournalReplayer::readString(std::vector<char> &storage)
+{
+    uint32 length = readVarint();
+    if(pos > size || length > size - pos)
+    {
+        pos = size + 1;
+        length = 0;
+    }
+    storage.assign(length + 1, 0);
+    for(uint32 i=0; i<length; i++)
+    {
+        storage[i] = (char)readU8();
+    }
+    return &storage[0];
+}
+
+void GB2JournalReplayer::applyFilterBits(b2Body *body, GB2JournalFilterOp filterOp, uint16 bits, const char *fixtureId)
+{
+    NSString *fid = (fixtureId && *fixtureId) ? [NSString stringWithUTF8String:fixtureId] : nil;
+    for(b2Fixture *f = body->GetFixtureList(); f; f = f->GetNext())
+    {
+        if(fid && ![fid isEqualToString:(NSString*)f->GetUserData()])
+        {
+            continue;
+        }
+        
+        b2Filter filter = f->GetFilterData();
+        switch(filterOp)
+        {
+            case kGB2JournalSetMask:        filter.maskBits = bits; break;
+            case kGB2JournalAddMask:        filter.maskBits |= bits; break;
+            case kGB2JournalClrMask:        filter.maskBits &= ~bits; break;
+            case kGB2JournalSetCategory:    filter.categoryBits = bits; break;
+            case kGB2JournalAddCategory:    filter.categoryBits |= bits; break;
+            case kGB2JournalClrCategory:    filter.categoryBits &= ~bits; break;
+        }
+        f->SetFilterData(filter);
+    }
+}
+
+bool GB2JournalReplayer::createFixture(b2Body *body, std::vector<char> &stringStorage)
+{
+    b2CircleShape circle;
+    b2EdgeShape edge;
+    b2PolygonShape polygon;
+    b2ChainShape chain;
+    
+    b2FixtureDef fixtureDef;
+    switch((b2Shape::Type)readU8())
+    {
+        case b2Shape::e_circle:
+            circle.m_radius = readFloat();
+            circle.m_p = readVec2();
+            fixtureDef.shape = &circle;
+            break;
+        case b2Shape::e_edge:
+        {
+            b2Vec2 v1 = readVec2();
+            b2Vec2 v2 = readVec2();
+            edge.Set(v1, v2);
+            uint8 flags = readU8();
+            edge.m_hasVertex0 = (flags & 1) != 0;
+            edge.m_hasVertex3 = (flags & 2) != 0;
+            edge.m_vertex0 = readVec2();
+            edge.m_vertex3 = readVec2();
+            fixtureDef.shape = &edge;
+            break;
+        }
+        case b2Shape::e_polygon:
+        {
+            b2Vec2 vertices[b2_maxPolygonVertices];
+            int32 count = readU8();
+            if(count < 3 || count > b2_maxPolygonVertices)
+            {
+                return false;
+            }
+            for(int32 i=0; i<count; i++)
+            {
+                vertices[i] = readVec2();
+            }
+            if(truncated())
+            {
+                return false;
+            }
+            polygon.Set(vertices, count);
+            fixtureDef.shape = &polygon;
+            break;
+        }
+        case b2Shape::e_chain:
+        {
+            uint32 count = readVarint();
+            if(count < 2 || pos > size || count > (size - pos) / sizeof(b2Vec2))
+            {
+                return false;
+            }
+            std::vector<b2Vec2> vertices(count);
+            for(size_t i=0; i<vertices.size(); i++)
+            {
+                vertices[i] = readVec2();
+            }
+            chain.CreateChain(&vertices[0], (int32)vertices.size());
+            uint8 flags = readU8();
+            b2Vec2 prevVertex = readVec2();
+            b2Vec2 nextVertex = readVec2();
+            if(flags & 1)
+            {
+                chain.SetPrevVertex(prevVertex);
+            }
+            if(flags & 2)
+            {
+                chain.SetNextVertex(nextVertex);
+            }
+            fixtureDef.shape = &chain;
+            break;
+        }
+        default:
+            // unknown shape - the journal is corrupt
+            return false;
+    }
+    
+    fixtureDef.density = readFloat();
+    fixtureDef.friction = readFloat();
+    fixtureDef.restitution = readFloat();
+    fixtureDef.isSensor = readU8() != 0;
+    fixtureDef.filter.categoryBits = (uint16)readVarint();
+    fixtureDef.filter.maskBits = (uint16)readVarint();
+    fixtureDef.filter.groupIndex = (int16)(uint16)readVarint();
+    
+    const char *fixtureId = readString(stringStorage);
+    if(truncated())
+    {
+        return false;
+    }
+    if(*fixtureId)
+    {
+        NSString *fid = [[NSString alloc] initWithUTF8String:fixtureId];
+        fixtureIds.push_back(fid);
+        fixtureDef.userData = fid;
+    }
+    
+    body->CreateFixture(&fixtureDef);
+    return true;
+}
+
+bool GB2JournalReplayer::run(b2World *world)
+{
+    GB2ShapeCache *shapeCache = [GB2ShapeCache sharedShapeCache];
+    std::vector<char> stringStorage;
+    
+    while(pos < size)
+    {
+        size_t recordOffset = pos;
+        GB2JournalOp op = (GB2JournalOp)readU8();
+        
+        if(op == kGB2JournalStep || op == kGB2JournalStepHash)
+        {
+            float32 dt = readFloat();
+            int32 velocityIterations = readU8();
+            int32 positionIterations = readU8();
+            uint32 recorded = (op == kGB2JournalStepHash) ? readU32() : 0;
+            if(truncated())
+            {
+                firstErrorOffset = (long)recordOffset;
+                return false;
+            }
+            
+            world->Step(dt, velocityIterations, positionIterations);
+            steps++;
+            
+            if(op == kGB2JournalStepHash)
+            {
+                if(GB2JournalHashWorld(world, false) != recorded && firstDivergentStep < 0)
+                {
+                    firstDivergentStep = steps;
+                }
+            }
+            continue;
+        }
+        
+        uint32 nodeId = readVarint();
+        if(op == kGB2JournalCreate)
+        {
+            b2BodyDef bodyDef;
+            uint8 bodyType = readU8();
+            if(truncated() || bodyType > b2_dynamicBody || bodies.count(nodeId))
+            {
+                firstErrorOffset = (long)recordOffset;
+                return false;
+            }
+            bodyDef.type = (b2BodyType)bodyType;
+            bodies[nodeId] = world->CreateBody(&bodyDef);
+            continue;
+        }
+        
+        std::map<uint32, b2Body*>::iterator it = bodies.find(nodeId);
+        if(it == bodies.end())
+        {
+            // the record of an unknown object - the journal is corrupt
+            firstErrorOffset = (long)recordOffset;
+            return false;
+        }
+        b2Body *body = it->second;
+        
+        bool valid = true;
+        switch(op)
+        {
+            case kGB2JournalDestroy:
+                world->DestroyBody(body);
+                bodies.erase(it);
+                break;
+            case kGB2JournalShape:
+            {
+                const char *shapeName = readString(stringStorage);
+                float32 scale = readFloat();
+                if(truncated())
+                {
+                    valid = false;
+                    break;
+                }
+                b2Fixture *f;
+                while((f = body->GetFixtureList()))
+                {
+                    body->DestroyFixture(f);
+                }
+                if(*shapeName)
+                {
+                    [shapeCache addFixturesToBody:body forShapeName:[NSString stringWithUTF8String:shapeName] scale:scale];
+                }
+                break;
+            }
+            case kGB2JournalEdge:
+            {
+                b2Vec2 start = readVec2();
+                b2Vec2 end = readVec2();
+                b2EdgeShape edgeShape;
+                edgeShape.Set(start, end);
+                body->CreateFixture(&edgeShape, 0);
+                break;
+            }
+            case kGB2JournalBodyType:
+            {
+                uint8 bodyType = readU8();
+                valid = bodyType <= b2_dynamicBody;
+                if(valid)
+                {
+                    body->SetType((b2BodyType)bodyType);
+                }
+                break;
+            }
+            case kGB2JournalLinearImpulse:
+            {
+                b2Vec2 impulse = readVec2();
+                b2Vec2 point = readVec2();
+                body->ApplyLinearImpulse(impulse, point);
+                break;
+            }
+            case kGB2JournalForce:
+            {
+                b2Vec2 force = readVec2();
+                b2Vec2 point = readVec2();
+                body->ApplyForce(force, point);
+                break;
+            }
+            case kGB2JournalTransform:
+            {
+                b2Vec2 position = readVec2();
+                float32 angle = readFloat();
+                body->SetTransform(position, angle);
+                break;
+            }
+            case kGB2JournalLinearVelocity:
+                body->SetLinearVelocity(readVec2());
+                break;
+            case kGB2JournalAngularVelocity:
+                body->SetAngularVelocity(readFloat());
+                break;
+            case kGB2JournalActive:
+                body->SetActive(readU8() != 0);
+                break;
+            case kGB2JournalBullet:
+                body->SetBullet(readU8() != 0);
+                break;
+            case kGB2JournalFixedRotation:
+                body->SetFixedRotation(readU8() != 0);
+                break;
+            case kGB2JournalAwake:
+                body->SetAwake(readU8() != 0);
+                break;
+            case kGB2JournalSleepingAllowed:
+                body->SetSleepingAllowed(readU8() != 0);
+                break;
+            case kGB2JournalFixture:
+                valid = createFixture(body, stringStorage);
+                break;
+            case kGB2JournalLinearDamping:
+                body->SetLinearDamping(readFloat());
+                break;
+            case kGB2JournalAngularDamping:
+                body->SetAngularDamping(readFloat());
+                break;
+            case kGB2JournalFilterBits:
+            {
+                GB2JournalFilterOp filterOp = (GB2JournalFilterOp)readU8();
+                uint16 bits = (uint16)readVarint();
+                const char *fixtureId = readString(stringStorage);
+                applyFilterBits(body, filterOp, bits, fixtureId);
+                break;
+            }
+            default:
+                // unknown record - the journal is corrupt
+                valid = false;
+                break;
+        }
+        
+        if(!valid || truncated())
+        {
+            firstErrorOffset = (long)recordOffset;
+            return false;
+        }
+    }
+    
+    return firstDivergentStep < 0;
+}
@@ -0,0 +1,280 @@
+/*
+ MIT License
+ 
+ Copyright (c) 2010 Andreas Loew / www.code-and-web.de
+ 
+ For more information about htis module visit
+ http://www.PhysicsEditor.de
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#include <math.h>
+#include <algorithm>
+#include "GB2KinematicController.h"
+#include "GB2Trace.h"
+
+/**
+ * Returns the eased progress for the linear progress t in [0,1]
+ */
+static inline float32 easeProgress(GB2MotionEase ease, float32 t)
+{
+    switch(ease)
+    {
+        case kGB2EaseLinear:    return t;
+        case kGB2EaseIn:        return t * t;
+        case kGB2EaseOut:       return t * (2.0f - t);
+        case kGB2EaseInOut:     return t * t * (3.0f - 2.0f * t);
+    }
+    return t;
+}
+
+GB2KinematicController::GB2KinematicController()
+{
+}
+
+GB2KinematicController::Mover &GB2KinematicController::moverForBody(b2Body *body)
+{
+    std::map<b2Body*, size_t>::iterator it = moverIndex.find(body);
+    if(it != moverIndex.end())
+    {
+        return movers[it->second];
+    }
+    
+    moverIndex[body] = movers.size();
+    movers.push_back(Mover());
+    
+    Mover &mover = movers.back();
+    mover.body = body;
+    mover.moving = false;
+    mover.loop = false;
+    mover.rotating = false;
+    return mover;
+}
+
+void GB2KinematicController::setPath(Mover &mover, const b2Vec2 *points, int32 count, float32 duration, GB2MotionEase ease, bool loop)
+{
+    mover.points.assign(points, points + count);
+    if(loop)
+    {
+        mover.points.push_back(points[0]);
+    }
+    
+    mover.distances.resize(mover.points.size());
+    float32 length = 0.0f;
+    for(size_t i=0; i<mover.points.size(); i++)
+    {
+        if(i > 0)
+        {
+            length += (mover.points[i] - mover.points[i-1]).Length();
+        }
+        mover.distances[i] = length;
+    }
+    
+    mover.moving = true;
+    mover.loop = loop && (duration > 0.0f);
+    mover.moveEase = ease;
+    mover.moveElapsed = 0.0f;
+    mover.moveDuration = duration;
+    mover.segment = 0;
+}
+
+void GB2KinematicController::moveTo(b2Body *body, const b2Vec2 &target, float32 duration, GB2MotionEase ease)
+{
+    b2Vec2 points[2] = { body->GetPosition(), target };
+    setPath(moverForBody(body), points, 2, duration, ease, false);
+}
+
+void GB2KinematicController::moveBy(b2Body *body, const b2Vec2 &delta, float32 duration, GB2MotionEase ease)
+{
+    moveTo(body, body->GetPosition() + delta, duration, ease);
+}
+
+void GB2KinematicController::rotateTo(b2Body *body, float32 angle, float32 duration, GB2MotionEase ease)
+{
+    Mover &mover = moverForBody(body);
+    mover.rotating = true;
+    mover.rotateEase = ease;
+    mover.rotateElapsed = 0.0f;
+    mover.rotateDuration = duration;
+    mover.fromAngle = body->GetAngle();
+    mover.toAngle = angle;
+}
+
+void GB2KinematicController::rotateBy(b2Body *body, float32 angle, float32 duration, GB2MotionEase ease)
+{
+    rotateTo(body, body->GetAngle() + angle, duration, ease);
+}
+
+void GB2KinematicController::followPath(b2Body *body, const b2Vec2 *points, int32 count, float32 speed, bool loop)
+{
+    b2Assert(count > 0 && speed > 0.0f);
+    
+    Mover &mover = moverForBody(body);
+    setPath(mover, points, count, 0.0f, kGB2EaseLinear, loop);
+    mover.moveDuration = mover.distances.back() / speed;
+    mover.loop = loop && (mover.moveDuration > 0.0f);
+}
+
+void GB2KinematicController::remove(size_t index)
+{
+    moverIndex.erase(movers[index].body);
+    if(index + 1 < movers.size())
+    {
+        // move the last mover into the gap
+        movers[index] = movers.back();
+        moverIndex[movers[index].body] = index;
+    }
+    movers.pop_back();
+}
+
+void GB2KinematicController::stop(b2Body *body)
+{
+    std::map<b2Body*, size_t>::iterator it = moverIndex.find(body);
+    if(it != moverIndex.end())
+    {
+        remove(it->second);
+        body->SetLinearVelocity(b2Vec2(0.0f, 0.0f));
+        body->SetAngularVelocity(0.0f);
+    }
+}
+
+void GB2KinematicController::removeBody(b2Body *body)
+{
+    std::map<b2Body*, size_t>::iterator it = moverIndex.find(body);
+    if(it != moverIndex.end())
+    {
+        remove(it->second);
+    }
+    
+    // keep the indices, the list might be read by the caller
+    std::replace(finishedBodies.begin(), finishedBodies.end(), body, (b2Body*)0);
+}
+
+void GB2KinematicController::clear()
+{
+    movers.clear();
+    moverIndex.clear();
+    finishedBodies.clear();
+}
+
+bool GB2KinematicController::isMoving(b2Body *body) const
+{
+    return moverIndex.find(body) != moverIndex.end();
+}
+
+b2Vec2 GB2KinematicController::pathPosition(Mover &mover, float32 distance)
+{
+    const std::vector<float32> &d = mover.distances;
+    int32 last = (int32)d.size() - 1;
+    if(last <= 0)
+    {
+        return mover.points[0];
+    }
+    
+    // the distance only grows, except when a loop starts over
+    if(distance < d[mover.segment])
+    {
+        mover.segment = 0;
+    }
+    while(mover.segment < last - 1 && distance > d[mover.segment + 1])
+    {
+        mover.segment++;
+    }
+    
+    int32 i = mover.segment;
+    float32 segmentLength = d[i+1] - d[i];
+    float32 t = (segmentLength > 0.0f) ? b2Clamp((distance - d[i]) / segmentLength, 0.0f, 1.0f) : 1.0f;
+    return mover.points[i] + t * (mover.points[i+1] - mover.points[i]);
+}
+
+void GB2KinematicController::step(float32 timeStep)
+{
+    GB2_TRACE_SCOPE("GB2KinematicController::step");
+    
+    finishedBodies.clear();
+    if(timeStep <= 0.0f)
+    {
+        return;
+    }
+    float32 invTimeStep = 1.0f / timeStep;
+    
+    for(size_t i=0; i<movers.size(); )
+    {
+        Mover &mover = movers[i];
+        b2Body *body = mover.body;
+        
+        if(!mover.moving && !mover.rotating)
+        {
+            // the motion reached its end in the last step
+            body->SetLinearVelocity(b2Vec2(0.0f, 0.0f));
+            body->SetAngularVelocity(0.0f);
+            finishedBodies.push_back(body);
+            remove(i);
+            continue;
+        }
+        
+        // position and angle of the motion at the end of the step
+        b2Vec2 position = body->GetPosition();
+        float32 angle = body->GetAngle();
+        
+        if(mover.moving)
+        {
+            mover.moveElapsed += timeStep;
+            float32 t = 1.0f;
+            if(mover.loop)
+            {
+                mover.moveElapsed = fmodf(mover.moveElapsed, mover.moveDuration);
+                t = mover.moveElapsed / mover.moveDuration;
+            }
+            else if(mover.moveElapsed < mover.moveDuration)
+            {
+                t = mover.moveElapsed / mover.moveDuration;
+            }
+            else
+            {
+                mover.moving = false;
+            }
+            position = pathPosition(mover, easeProgress(mover.moveEase, t) * mover.distances.back());
+        }
+        
+        if(mover.rotating)
+        {
+            mover.rotateElapsed += timeStep;
+            float32 t = 1.0f;
+            if(mover.rotateElapsed < mover.rotateDuration)
+            {
+                t = mover.rotateElapsed / mover.rotateDuration;
+            }
+            else
+            {
+                mover.rotating = false;
+            }
+            angle = mover.fromAngle + easeProgress(mover.rotateEase, t) * (mover.toAngle - mover.fromAngle);
+        }
+        
+        // box2d integrates the center of mass - move it to where it
+        // is when the origin and angle match the motion
+        b2Vec2 center = position + b2Mul(b2Rot(angle), body->GetLocalCenter());
+        body->SetLinearVelocity(invTimeStep * (center - body->GetWorldCenter()));
+        body->SetAngularVelocity(invTimeStep * (angle - body->GetAngle()));
+        
+        i++;
+    }
+}
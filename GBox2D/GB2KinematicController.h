@@ -0,0 +1,174 @@
+/*
+ MIT License
+ 
+ Copyright (c) 2010 Andreas Loew / www.code-and-web.de
+ 
+ For more information about htis module visit
+ http://www.PhysicsEditor.de
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#include <map>
+#include <vector>
+#include "Box2D.h"
+
+#pragma once
+
+/**
+ * Easing of a motion
+ */
+enum GB2MotionEase
+{
+    kGB2EaseLinear,
+    kGB2EaseIn,             //!< accelerate from zero speed
+    kGB2EaseOut,            //!< decelerate to zero speed
+    kGB2EaseInOut           //!< accelerate and decelerate
+};
+
+/**
+ * GB2KinematicController
+ *
+ * Drives kinematic bodies with velocities instead of SetTransform
+ *
+ * Moves, rotations and paths are turned into the linear and angular
+ * velocity which brings the body to the position of the motion at
+ * the end of the next step. The body stays in the broadphase, is
+ * swept continuously and objects riding on it get proper friction.
+ * The velocity is computed from the body's actual position, so the
+ * body can't drift from the motion.
+ *
+ * Translation and rotation are independent - a move does not stop
+ * a rotation and vice versa. All movers are updated together in
+ * step(), which must be called right before b2World::Step.
+ * GB2Simulation does this.
+ */
+class GB2KinematicController
+{
+public:
+    GB2KinematicController();
+    
+    /**
+     * Moves the body's origin to the target position
+     * Replaces the current translation of the body.
+     * @param body kinematic body to move
+     * @param target target position
+     * @param duration duration in seconds
+     * @param ease easing of the motion
+     */
+    void moveTo(b2Body *body, const b2Vec2 &target, float32 duration, GB2MotionEase ease = kGB2EaseLinear);
+    void moveBy(b2Body *body, const b2Vec2 &delta, float32 duration, GB2MotionEase ease = kGB2EaseLinear);
+    
+    /**
+     * Rotates the body around its origin to the target angle
+     * Replaces the current rotation of the body.
+     * @param body kinematic body to rotate
+     * @param angle target angle in radians
+     * @param duration duration in seconds
+     * @param ease easing of the motion
+     */
+    void rotateTo(b2Body *body, float32 angle, float32 duration, GB2MotionEase ease = kGB2EaseLinear);
+    void rotateBy(b2Body *body, float32 angle, float32 duration, GB2MotionEase ease = kGB2EaseLinear);
+    
+    /**
+     * Moves the body's origin along a polyline with constant speed
+     * The path starts at the first point - the body gets there
+     * within the first step. A looped path returns from the last
+     * to the first point and never ends.
+     * @param body kinematic body to move
+     * @param points points of the path
+     * @param count number of points
+     * @param speed speed in m/s
+     * @param loop true to repeat the path
+     */
+    void followPath(b2Body *body, const b2Vec2 *points, int32 count, float32 speed, bool loop);
+    
+    /**
+     * Stops all motions of the body and sets its velocity to zero
+     */
+    void stop(b2Body *body);
+    
+    /**
+     * Removes the body without touching it
+     * Must be called before a moving body is destroyed.
+     */
+    void removeBody(b2Body *body);
+    
+    /**
+     * Removes all bodies
+     */
+    void clear();
+    
+    /**
+     * Returns true if the body has a motion
+     */
+    bool isMoving(b2Body *body) const;
+    
+    /**
+     * Sets the velocities of all moving bodies for the next step
+     * @param timeStep duration of the next step
+     */
+    void step(float32 timeStep);
+    
+    /**
+     * Returns the bodies whose motions ended during the last step()
+     * Bodies removed with removeBody() afterwards are set to NULL,
+     * the list can be read while callbacks destroy bodies.
+     */
+    const std::vector<b2Body*> &getFinishedBodies() const { return finishedBodies; }
+    
+    /**
+     * Returns the moving bodies
+     */
+    int32 getMoverCount() const { return (int32)movers.size(); }
+    b2Body *getMoverBody(int32 index) const { return movers[index].body; }
+    
+private:
+    struct Mover
+    {
+        b2Body *body;
+        
+        // translation along a polyline, a move is a path with 2 points
+        bool moving;
+        bool loop;
+        GB2MotionEase moveEase;
+        float32 moveElapsed;
+        float32 moveDuration;
+        int32 segment;                      // current segment of the path
+        std::vector<b2Vec2> points;
+        std::vector<float32> distances;     // path length at each point
+        
+        // rotation
+        bool rotating;
+        GB2MotionEase rotateEase;
+        float32 rotateElapsed;
+        float32 rotateDuration;
+        float32 fromAngle;
+        float32 toAngle;
+    };
+    
+    Mover &moverForBody(b2Body *body);
+    void setPath(Mover &mover, const b2Vec2 *points, int32 count, float32 duration, GB2MotionEase ease, bool loop);
+    static b2Vec2 pathPosition(Mover &mover, float32 distance);
+    void remove(size_t index);
+    
+    std::vector<Mover> movers;
+    std::map<b2Body*, size_t> moverIndex;   // body -> index in movers
+    std::vector<b2Body*> finishedBodies;
+};
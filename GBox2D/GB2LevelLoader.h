@@ -0,0 +1,146 @@
+/*
+ MIT License
+ 
+ Copyright (c) 2010 Andreas Loew / www.code-and-web.de
+ 
+ For more information about htis module visit
+ http://www.PhysicsEditor.de
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import "cocos2d.h"
+#import "Box2D.h"
+#import "GB2Node.h"
+
+#pragma once
+
+/**
+ * Block creating one object of a level
+ * @return the created object
+ */
+typedef GB2Node*(^GB2LevelLoaderFactory)(void);
+
+/**
+ * Block receiving the loading progress
+ * @param progress value between 0 and 1
+ */
+typedef void(^GB2LevelLoaderProgress)(float progress);
+
+/**
+ * Block called when the level is completely loaded
+ * @param objects all objects created by the loader
+ */
+typedef void(^GB2LevelLoaderCompletion)(NSArray *objects);
+
+/**
+ * GB2LevelLoader
+ *
+ * Loads a level spread across several frames
+ *
+ * The shape files are parsed on a background thread. The
+ * objects are created on the main thread, each frame creates
+ * objects until the frame budget is used up.
+ *
+ * Usage:
+ *   GB2LevelLoader *loader = [GB2LevelLoader loader];
+ *   [loader addShapeFile:@"shapes.plist"];
+ *   [loader addBodyWithShape:@"rock" bodyType:b2_staticBody position:pos angle:0 node:sprite];
+ *   loader.progressBlock = ^(float progress) { ... };
+ *   loader.completionBlock = ^(NSArray *objects) { ... };
+ *   [loader start];
+ *
+ * The loader retains itself until loading is complete or
+ * cancelled.
+ */
+@interface GB2LevelLoader : NSObject
+{
+    NSMutableArray *shapeFiles;             //!< names of the shape files to load
+    NSMutableArray *factories;              //!< blocks creating the objects
+    NSMutableArray *objects;                //!< objects created so far
+    NSUInteger numParsedFiles;              //!< number of shape files already added to the cache
+    NSUInteger nextFactory;                 //!< index of the next object to create
+    float budget;                           //!< milliseconds per frame for creating objects
+    BOOL running;                           //!< YES while loading
+    GB2LevelLoaderProgress progressBlock;
+    GB2LevelLoaderCompletion completionBlock;
+}
+
+/**
+ * Milliseconds per frame spent on creating objects
+ * At least one object is created per frame. Default is 4ms.
+ */
+@property (nonatomic, assign) float budget;
+
+/**
+ * Called each frame with the current progress
+ */
+@property (nonatomic, copy) GB2LevelLoaderProgress progressBlock;
+
+/**
+ * Called once all objects are created
+ */
+@property (nonatomic, copy) GB2LevelLoaderCompletion completionBlock;
+
+/**
+ * Returns YES while the loader is running
+ */
+@property (nonatomic, readonly) BOOL running;
+
+/**
+ * Creates an autoreleased loader
+ */
++(id) loader;
+
+/**
+ * Adds a shape file to load
+ * All shape files are loaded before the objects are created
+ * @param plist name of the plist file
+ */
+-(void) addShapeFile:(NSString*)plist;
+
+/**
+ * Adds an object with the given shape
+ * @param shape name of the physics shape to use
+ * @param bodyType type of the body
+ * @param pos position in physics coordinates
+ * @param angle angle of the body
+ * @param node CCNode to use for the object, might be nil
+ */
+-(void) addBodyWithShape:(NSString*)shape bodyType:(b2BodyType)bodyType position:(b2Vec2)pos angle:(float)angle node:(CCNode*)node;
+
+/**
+ * Adds an object created by a block
+ * Use this to create GB2Node subclasses
+ * @param factory block creating the object
+ */
+-(void) addObjectWithBlock:(GB2LevelLoaderFactory)factory;
+
+/**
+ * Starts loading
+ */
+-(void) start;
+
+/**
+ * Stops loading
+ * Objects already created stay in the world
+ */
+-(void) cancel;
+
+@end
@@ -0,0 +1,218 @@
+/*
+ MIT License
+ 
+ Copyright (c) 2010 Andreas Loew / www.code-and-web.de
+ 
+ For more information about htis module visit
+ http://www.PhysicsEditor.de
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import <QuartzCore/QuartzCore.h>
+#import "GB2LevelLoader.h"
+#import "GB2ShapeCache.h"
+
+// default frame budget in milliseconds
+static const float kGB2LevelLoaderDefaultBudget = 4.0f;
+
+@interface GB2LevelLoader (private_selectors)
+- (void)shapesParsed:(NSArray*)parsedShapes;
+- (void)reportProgress;
+- (void)finish;
+@end
+
+@implementation GB2LevelLoader
+
+@synthesize budget;
+@synthesize progressBlock;
+@synthesize completionBlock;
+@synthesize running;
+
++(id) loader
+{
+    return [[[self alloc] init] autorelease];
+}
+
+-(id) init
+{
+    self = [super init];
+    if(self)
+    {
+        shapeFiles = [[NSMutableArray alloc] init];
+        factories = [[NSMutableArray alloc] init];
+        objects = [[NSMutableArray alloc] init];
+        budget = kGB2LevelLoaderDefaultBudget;
+    }
+    return self;
+}
+
+-(void) dealloc
+{
+    [shapeFiles release];
+    [factories release];
+    [objects release];
+    [progressBlock release];
+    [completionBlock release];
+    [super dealloc];
+}
+
+-(void) addShapeFile:(NSString*)plist
+{
+    NSAssert(!running, @"GB2LevelLoader: can't add shape files while loading");
+    [shapeFiles addObject:plist];
+}
+
+-(void) addBodyWithShape:(NSString*)shape bodyType:(b2BodyType)bodyType position:(b2Vec2)pos angle:(float)angle node:(CCNode*)node
+{
+    [self addObjectWithBlock:^GB2Node*{
+        GB2Node *o = [[[GB2Node alloc] initWithShape:shape bodyType:bodyType node:node] autorelease];
+        [o setTransform:pos angle:angle];
+        [o updateCCFromPhysics];
+        return o;
+    }];
+}
+
+-(void) addObjectWithBlock:(GB2LevelLoaderFactory)factory
+{
+    NSAssert(!running, @"GB2LevelLoader: can't add objects while loading");
+    GB2LevelLoaderFactory f = [factory copy];
+    [factories addObject:f];
+    [f release];
+}
+
+-(void) start
+{
+    NSAssert(!running, @"GB2LevelLoader: already running");
+    running = YES;
+    
+    // keep the loader alive until loading is done
+    [self retain];
+    
+    // get the cache on the main thread, parsing does not modify it
+    GB2ShapeCache *shapeCache = [GB2ShapeCache sharedShapeCache];
+    NSArray *files = [[shapeFiles copy] autorelease];
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+        
+        NSMutableArray *parsedShapes = [NSMutableArray arrayWithCapacity:[files count]];
+        for(NSString *file in files)
+        {
+            [parsedShapes addObject:[shapeCache parseShapesWithFile:file]];
+        }
+        
+        // add shapes and create the objects on the main thread
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [self shapesParsed:parsedShapes];
+        });
+        
+        [pool drain];
+    });
+}
+
+-(void) cancel
+{
+    if(!running)
+    {
+        return;
+    }
+    
+    // stop creating objects - shapes which are still parsed
+    // are ignored by shapesParsed:
+    running = NO;
+    [[CCDirector sharedDirector].scheduler unscheduleUpdateForTarget:self];
+    [self release];
+}
+
+-(void) shapesParsed:(NSArray*)parsedShapes
+{
+    if(!running)
+    {
+        return;
+    }
+    
+    GB2ShapeCache *shapeCache = [GB2ShapeCache sharedShapeCache];
+    for(id shapes in parsedShapes)
+    {
+        [shapeCache addParsedShapes:shapes];
+        numParsedFiles++;
+    }
+    [self reportProgress];
+    
+    // create the objects in the update phase
+    [[CCDirector sharedDirector].scheduler scheduleUpdateForTarget:self priority:0 paused:NO];
+}
+
+-(void) update:(ccTime)dt
+{
+    CFTimeInterval endTime = CACurrentMediaTime() + budget / 1000.0;
+    NSUInteger count = [factories count];
+    
+    // create at least one object per frame
+    do
+    {
+        if(nextFactory >= count)
+        {
+            break;
+        }
+        
+        GB2LevelLoaderFactory factory = [factories objectAtIndex:nextFactory++];
+        GB2Node *o = factory();
+        if(o)
+        {
+            [objects addObject:o];
+        }
+    }
+    while(CACurrentMediaTime() < endTime);
+    
+    [self reportProgress];
+    
+    if(nextFactory >= count)
+    {
+        [self finish];
+    }
+}
+
+-(void) reportProgress
+{
+    if(progressBlock)
+    {
+        NSUInteger total = [shapeFiles count] + [factories count];
+        float progress = total ? (float)(numParsedFiles + nextFactory) / (float)total : 1.0f;
+        progressBlock(progress);
+    }
+}
+
+-(void) finish
+{
+    running = NO;
+    [[CCDirector sharedDirector].scheduler unscheduleUpdateForTarget:self];
+    
+    // release the blocks, they retain the nodes
+    [factories removeAllObjects];
+    
+    if(completionBlock)
+    {
+        completionBlock(objects);
+    }
+    
+    [self release];
+}
+
+@end
@@ -29,6 +29,7 @@
 #import "Box2D.h"
 #import "GB2ShapeCache.h"
 #import "GB2Engine.h"
+#import "GB2KinematicController.h"
 
 @interface GB2Node : NSObject
 {
@@ -38,6 +39,14 @@
     int objectTag;      //!< tag might be used to query an object
     CCNode *ccNode;     //!< reference to the ccNode, retained
     bool deleteLater;   //!< flag to delete the object on update phase
+    NSString *shapeName;//!< name of the current physics shape, retained
+    float shapeScale;   //!< scale of the physics shape
+    uint32 nodeId;      //!< unique id of the object, used in the journal
+    float minExtent;    //!< smallest fixture extent of the shape, 0 if unknown
+    bool manualBullet;  //!< bullet flag was set with setBullet:
+    GB2ShapeLOD shapeLOD;//!< level of detail of the current fixtures
+    int shapeFixtures;  //!< number of fixtures of the shape at full detail
+    int lodFixtures;    //!< number of fixtures at the current level of detail
 @protected
 }
 
@@ -85,6 +94,8 @@
 
 /**
  * Adds a fixture to the body
+ * The fixture is recorded in the journal, its user data must be
+ * a fixture id (NSString) or NULL.
  * @param fixtureDef fixture definition
  * @return the added fixture
  */
@@ -110,11 +121,119 @@
  */
 -(void) stopAction: (CCAction*) action;
 
+/**
+ * Adds the CCNode to the parent node
+ * If automatic sprite batching is enabled in GB2Engine, a CCSprite
+ * without children is added to a CCSpriteBatchNode for its texture
+ * and z order instead. The batch nodes are created under the parent
+ * and removed when their last sprite is deleted. Sprites with the
+ * same z order but different textures are drawn in the order of
+ * their batch nodes.
+ * @param parent parent node
+ */
+-(void) setParent:(CCNode*)parent;
+
+/**
+ * Adds the CCNode to the parent node with the given z order
+ * @param parent parent node
+ * @param z z order
+ */
+-(void) setParent:(CCNode*)parent z:(float)z;
+
+/**
+ * Sets the display frame of the inner CCSprite
+ * A batched sprite is moved to the batch node of the new
+ * texture if the frame is on a different texture.
+ * @param frame frame to set
+ */
+-(void) setSpriteDisplayFrame:(CCSpriteFrame*)frame;
+
 /**
  * Sets the CCNode to visible/invisible
  */
 -(void) setVisible:(BOOL)isVisible;
 
+/**
+ * Moves a kinematic object to the position
+ * The motion is applied as velocity each step instead of
+ * teleporting the body. Replaces the current move of the object.
+ * The object receives kinematicMotionFinished if it implements it
+ * when all its motions ended.
+ * @param position target position in physics coordinates
+ * @param duration duration in seconds
+ */
+-(void) moveTo:(b2Vec2)position duration:(float)duration;
+
+/**
+ * Moves a kinematic object to the position with easing
+ * @param position target position in physics coordinates
+ * @param duration duration in seconds
+ * @param ease easing of the motion
+ */
+-(void) moveTo:(b2Vec2)position duration:(float)duration ease:(GB2MotionEase)ease;
+
+/**
+ * Moves a kinematic object by the offset
+ * @param delta offset in physics coordinates
+ * @param duration duration in seconds
+ */
+-(void) moveBy:(b2Vec2)delta duration:(float)duration;
+
+/**
+ * Rotates a kinematic object around its origin to the angle
+ * Replaces the current rotation of the object.
+ * @param angle target angle in radians
+ * @param duration duration in seconds
+ */
+-(void) rotateTo:(float)angle duration:(float)duration;
+
+/**
+ * Rotates a kinematic object by the angle
+ * @param angle angle in radians
+ * @param duration duration in seconds
+ */
+-(void) rotateBy:(float)angle duration:(float)duration;
+
+/**
+ * Moves a kinematic object along a path with constant speed
+ * @param points path in physics coordinates, starting with the first point
+ * @param count number of points
+ * @param speed speed in m/s
+ * @param loop YES to repeat the path until stopMotion is called
+ */
+-(void) followPath:(const b2Vec2*)points count:(int)count speed:(float)speed loop:(BOOL)loop;
+
+/**
+ * Returns YES if an object of the class or a subclass touches
+ * the object, sensor contacts included
+ * Answered from the touching state GB2Engine keeps from the begin
+ * and end contacts, no contacts are walked. Requires GB2Engine's
+ * trackTouching, returns NO otherwise.
+ * @param cls class of the other object
+ */
+-(BOOL) isTouchingClass:(Class)cls;
+
+/**
+ * Returns YES if a fixture with the id touches another object
+ * @param fixtureId id of the fixture in PhysicsEditor
+ */
+-(BOOL) isTouchingFixtureId:(NSString*)fixtureId;
+
+/**
+ * Returns the objects touching the object
+ */
+-(NSArray*) touchingNodes;
+
+/**
+ * Stops all motions and sets the velocities to zero
+ */
+-(void) stopMotion;
+
+/**
+ * Returns YES while the object has a kinematic motion
+ */
+-(BOOL) isMoving;
+
 /**
  * Sets the object's angle
  * @param angle angle to set
@@ -128,7 +247,10 @@
 -(void)setCcPosition:(CGPoint)p;
 
 /**
- * Scales the graphics (currently not the object!)
+ * Scales the graphics and the physics shape
+ * The fixtures are replaced with a scaled version of the
+ * current shape - changes to the fixtures (e.g. collision
+ * bits) are lost.
  * @param scale scale to set
  */
 -(void) setScale:(float)scale;
@@ -154,6 +276,17 @@
  */
 -(void) updateCCFromPhysics;
 
+/**
+ * Called by GB2Engine when a journal is started to record
+ * the current state of the object
+ */
+-(void) recordJournalSnapshot;
+
+/**
+ * Returns the object's unique id
+ */
+-(uint32) nodeId;
+
 /**
  * Replaces the current fixtures with the new shape
  * @param shapeName name of the shape to set
@@ -299,9 +432,62 @@
 /**
  * Sets the object to bullet mode and activates continuous collision
  * detection for the object
+ * The object is taken out of the automatic bullet management
  */
 -(void) setBullet:(bool)bulletFlag;
 
+/**
+ * Puts the object back under the automatic bullet management
+ * of GB2Engine
+ */
+-(void) setAutomaticBullet;
+
+/**
+ * Called by GB2Engine to set the bullet flag if the object
+ * moves further than a fraction of its smallest fixture
+ * extent in the next step. Only objects with a shape from the
+ * shape cache are managed.
+ * @param timeStep duration of the next step
+ * @param fraction fraction of the smallest extent
+ * @return true if the object is in bullet mode
+ */
+-(bool) updateBulletForTimeStep:(float)timeStep fraction:(float)fraction;
+
+/**
+ * Returns the level of detail of the physics shape
+ */
+-(GB2ShapeLOD) shapeLOD;
+
+/**
+ * Replaces the fixtures with a coarser or finer version of the shape
+ * Collision filters changed at runtime are kept per fixture id, the
+ * mass of dynamic objects stays the same. Fixtures added with
+ * addFixture: are lost. Contacts of the old fixtures end and begin
+ * again in the next step. setBodyShape: and setScale: go back to
+ * full detail. Coarse levels are ignored while a journal is recorded.
+ * @param lod level of detail
+ */
+-(void) setShapeLOD:(GB2ShapeLOD)lod;
+
+/**
+ * Called by GB2Engine to select the level of detail by the distance
+ * of the object's fixture bounds to a center. Coarser levels are used from their
+ * distance on, finer levels only below the distance of the current
+ * level minus the hysteresis. Only objects with a shape from the
+ * shape cache and no fixtures added with addFixture: or
+ * addEdgeFrom:to: are managed.
+ * @param center center in physics coordinates
+ * @param distances distance per level, kGB2ShapeLODLevels entries, 0 disables a level
+ * @param hysteresis distance to come closer before using a finer level
+ * @return true if the fixtures were replaced
+ */
+-(bool) updateShapeLODWithCenter:(b2Vec2)center distances:(const float*)distances hysteresis:(float)hysteresis;
+
+/**
+ * Returns the number of fixtures the level of detail saves
+ */
+-(int) fixturesSavedByLOD;
+
 /**
  * Destroys the physics body of the object
  */
@@ -25,9 +25,185 @@
  THE SOFTWARE.
  */
 
+#import <vector>
 #import "GB2Node.h"
 #import "GB2Engine.h"
 #import "GB2ShapeCache.h"
+#import "GB2Journal.h"
+#import "GB2Simulation.h"
+#import "GB2Trace.h"
+
+// id of the next object
+static uint32 nextNodeId = 1;
+
+// tag of the CCSpriteBatchNodes created by the automatic sprite batching
+static const NSInteger kGB2AutoBatchTag = 0x47423242;
+
+/**
+ * Returns true if the node is a CCSprite which can be
+ * drawn by a CCSpriteBatchNode
+ */
+static inline BOOL canBatchNode(CCNode *node)
+{
+    return [node isKindOfClass:[CCSprite class]]
+        && ((CCSprite*)node).texture
+        && ([node.children count] == 0);
+}
+
+/**
+ * Returns true if the node is a batch node of the automatic sprite batching
+ */
+static inline BOOL isAutoBatchNode(CCNode *node)
+{
+    return (node.tag == kGB2AutoBatchTag) && [node isKindOfClass:[CCSpriteBatchNode class]];
+}
+
+/**
+ * Returns the batch node for the sprite's texture and blend function
+ * with the given z order under the parent, creates it if required
+ */
+static CCSpriteBatchNode *autoBatchNode(CCNode *parent, CCSprite *sprite, NSInteger z)
+{
+    ccBlendFunc blendFunc = sprite.blendFunc;
+    for(CCNode *child in parent.children)
+    {
+        if(isAutoBatchNode(child) && (child.zOrder == z))
+        {
+            CCSpriteBatchNode *batchNode = (CCSpriteBatchNode*)child;
+            if((batchNode.texture.name == sprite.texture.name)
+               && (batchNode.blendFunc.src == blendFunc.src)
+               && (batchNode.blendFunc.dst == blendFunc.dst))
+            {
+                return batchNode;
+            }
+        }
+    }
+    
+    CCSpriteBatchNode *batchNode = [CCSpriteBatchNode batchNodeWithTexture:sprite.texture];
+    batchNode.blendFunc = blendFunc;
+    [parent addChild:batchNode z:z tag:kGB2AutoBatchTag];
+    return batchNode;
+}
+
+/**
+ * Removes a batch node of the automatic sprite batching
+ * if it has no sprites left
+ */
+static inline void removeEmptyAutoBatchNode(CCNode *node)
+{
+    if(isAutoBatchNode(node) && ([node.children count] == 0))
+    {
+        [node removeFromParentAndCleanup:YES];
+    }
+}
+
+/**
+ * Returns the engine's kinematic controller
+ */
+static inline GB2KinematicController *kinematics()
+{
+    return [[GB2Engine sharedInstance] simulation]->getKinematics();
+}
+
+/**
+ * Records the body's current transform in the journal
+ */
+static inline void journalTransform(uint32 nodeId, b2Body *body)
+{
+    if(gb2Journal)
+    {
+        gb2Journal->recordTransform(nodeId, body->GetPosition(), body->GetAngle());
+    }
+}
+
+/**
+ * Records a fixture with its raw definition in the journal
+ * The user data is expected to be the fixture id
+ */
+static inline void journalFixture(uint32 nodeId, const b2FixtureDef &fixtureDef)
+{
+    if(gb2Journal)
+    {
+        gb2Journal->recordFixture(nodeId, fixtureDef, [(NSString*)fixtureDef.userData UTF8String]);
+    }
+}
+
+/**
+ * Records a collision filter change in the journal
+ */
+static inline void journalFilterBits(uint32 nodeId, GB2JournalFilterOp filterOp, uint16 bits, NSString *fixtureId)
+{
+    if(gb2Journal)
+    {
+        gb2Journal->recordFilterBits(nodeId, filterOp, bits, [fixtureId UTF8String]);
+    }
+}
+
+/**
+ * Returns the level of detail for the distance
+ * The coarsest level whose distance is reached is used, finer levels
+ * than the current one only below its distance minus the hysteresis.
+ */
+static GB2ShapeLOD lodForDistance(float distance, GB2ShapeLOD current, const float *distances, float hysteresis)
+{
+    GB2ShapeLOD lod = kGB2ShapeLODFull;
+    float lodDistance = 0.0f;
+    for(int level=kGB2ShapeLODFull+1; level<kGB2ShapeLODLevels; level++)
+    {
+        if(distances[level] > 0.0f && distance >= distances[level] && distances[level] >= lodDistance)
+        {
+            lod = (GB2ShapeLOD)level;
+            lodDistance = distances[level];
+        }
+    }
+    
+    float currentDistance = (current == kGB2ShapeLODFull) ? 0.0f : distances[current];
+    if(lodDistance < currentDistance && distance >= currentDistance - hysteresis)
+    {
+        return current;
+    }
+    return lod;
+}
+
+/**
+ * Returns the distance of the point to the fixture bounds of the body
+ * The body origin of large objects like terrain might be far away
+ * from the point while the point is on the object.
+ */
+static float distanceToFixtures(b2Body *body, const b2Vec2 &point)
+{
+    b2AABB bounds;
+    bool hasBounds = false;
+    for(b2Fixture *f = body->GetFixtureList(); f; f = f->GetNext())
+    {
+        for(int32 child=0; child<f->GetShape()->GetChildCount(); child++)
+        {
+            if(hasBounds)
+            {
+                bounds.Combine(f->GetAABB(child));
+            }
+            else
+            {
+                bounds = f->GetAABB(child);
+                hasBounds = true;
+            }
+        }
+    }
+    if(!hasBounds)
+    {
+        return b2Distance(point, body->GetPosition());
+    }
+    
+    b2Vec2 outside = b2Max(b2Max(bounds.lowerBound - point, point - bounds.upperBound), b2Vec2_zero);
+    return outside.Length();
+}
+
+static inline bool sameFilter(const b2Filter &a, const b2Filter &b)
+{
+    return a.categoryBits == b.categoryBits
+        && a.maskBits == b.maskBits
+        && a.groupIndex == b.groupIndex;
+}
 
 @implementation GB2Node
 
@@ -41,6 +217,8 @@
 	if( self ) 
     {
         world = [[GB2Engine sharedInstance] world];
+        shapeScale = 1.0f;
+        nodeId = nextNodeId++;
         
         b2BodyDef bodyDef;
         bodyDef.type = bodyType;
@@ -48,8 +226,14 @@
         bodyDef.angle = 0;
         body = world->CreateBody(&bodyDef);
         
+        if(gb2Journal)
+        {
+            gb2Journal->recordCreate(nodeId, bodyType);
+        }
+        
         // set user data and retain self
         body->SetUserData([self retain]);
+        [[GB2Engine sharedInstance] addObjectToIndex:self];
         
         // set the node
         self.ccNode = node;
@@ -69,6 +253,62 @@
     b2EdgeShape edgeShape;
     edgeShape.Set(start, end);
     body->CreateFixture(&edgeShape,0);
+    
+    if(gb2Journal)
+    {
+        gb2Journal->recordEdge(nodeId, start, end);
+    }
+}
+
+-(void) recordJournalSnapshot
+{
+    if(!gb2Journal || !body)
+    {
+        return;
+    }
+    
+    // the journal replays full shapes only
+    [self setShapeLOD:kGB2ShapeLODFull];
+    
+    gb2Journal->recordCreate(nodeId, body->GetType());
+    
+    // the fixtures as they are now - includes edges, added fixtures and
+    // changed filters. Recorded in creation order, the list is newest first.
+    gb2Journal->recordShape(nodeId, 0, shapeScale);
+    std::vector<b2Fixture*> fixtures;
+    for(b2Fixture *f = body->GetFixtureList(); f; f = f->GetNext())
+    {
+        fixtures.push_back(f);
+    }
+    for(size_t i=fixtures.size(); i>0; i--)
+    {
+        b2Fixture *f = fixtures[i-1];
+        b2FixtureDef fixtureDef;
+        fixtureDef.shape = f->GetShape();
+        fixtureDef.userData = f->GetUserData();
+        fixtureDef.friction = f->GetFriction();
+        fixtureDef.restitution = f->GetRestitution();
+        fixtureDef.density = f->GetDensity();
+        fixtureDef.isSensor = f->IsSensor();
+        fixtureDef.filter = f->GetFilterData();
+        journalFixture(nodeId, fixtureDef);
+    }
+    
+    journalTransform(nodeId, body);
+    gb2Journal->recordVec2Op(kGB2JournalLinearVelocity, nodeId, body->GetLinearVelocity());
+    gb2Journal->recordFloatOp(kGB2JournalAngularVelocity, nodeId, body->GetAngularVelocity());
+    gb2Journal->recordFloatOp(kGB2JournalLinearDamping, nodeId, body->GetLinearDamping());
+    gb2Journal->recordFloatOp(kGB2JournalAngularDamping, nodeId, body->GetAngularDamping());
+    gb2Journal->recordFlagOp(kGB2JournalFixedRotation, nodeId, body->IsFixedRotation());
+    gb2Journal->recordFlagOp(kGB2JournalBullet, nodeId, body->IsBullet());
+    gb2Journal->recordFlagOp(kGB2JournalActive, nodeId, body->IsActive());
+    gb2Journal->recordFlagOp(kGB2JournalSleepingAllowed, nodeId, body->IsSleepingAllowed());
+    gb2Journal->recordFlagOp(kGB2JournalAwake, nodeId, body->IsAwake());
+}
+
+-(uint32) nodeId
+{
+    return nodeId;
 }
 
 -(id) init
@@ -116,15 +356,33 @@
     return 0;
 }
 
+-(void) dealloc
+{
+    [shapeName release];
+    [ccNode release];
+    [super dealloc];
+}
+
 -(void) destroyBody
 {
     if(body)
     {
         // destroy the body and release the instance count
         // which was part of the body userdata
+        kinematics()->removeBody(body);
+        [[GB2Engine sharedInstance] removeObjectFromIndex:self];
         world->DestroyBody(body);
         body=0;
         
+        // the destroyed contacts left the sensor sets and touching lists
+        [[GB2Engine sharedInstance] removeObjectFromSensors:self];
+        [[GB2Engine sharedInstance] removeObjectFromTouching:self];
+        
+        if(gb2Journal)
+        {
+            gb2Journal->recordDestroy(nodeId);
+        }
+        
         // release self - 
         [self release];
     }
@@ -132,8 +390,12 @@
 
 -(void) deleteNow
 {    
+    GB2_TRACE_SCOPE("GB2Node::deleteNow");
+    
     // remove object from cocos2d parent node
+    CCNode *parent = ccNode.parent;
     [ccNode removeFromParentAndCleanup:YES];
+    removeEmptyAutoBatchNode(parent);
     self.ccNode = nil;
 
     // delete the body
@@ -158,14 +420,45 @@
 
 -(void) setParent:(CCNode*)parent
 {
+    if([GB2Engine sharedInstance].autoSpriteBatching && canBatchNode(ccNode))
+    {
+        [autoBatchNode(parent, (CCSprite*)ccNode, ccNode.zOrder) addChild:ccNode];
+        return;
+    }
     [parent addChild:ccNode];
 }
 
 -(void) setParent:(CCNode*)parent z:(float)z
 {
+    if([GB2Engine sharedInstance].autoSpriteBatching && canBatchNode(ccNode))
+    {
+        [autoBatchNode(parent, (CCSprite*)ccNode, z) addChild:ccNode];
+        return;
+    }
     [parent addChild:ccNode z:z];    
 }
 
+-(void) setSpriteDisplayFrame:(CCSpriteFrame*)frame
+{
+    CCSprite *sprite = (CCSprite*)ccNode;
+    CCNode *batchNode = sprite.parent;
+    if(!isAutoBatchNode(batchNode) || (frame.texture.name == sprite.texture.name))
+    {
+        [sprite setDisplayFrame:frame];
+        return;
+    }
+    
+    // a sprite in a batch node can't change its texture - move it
+    // to the batch node of the new texture
+    CCNode *parent = batchNode.parent;
+    NSInteger z = batchNode.zOrder;
+    [[sprite retain] autorelease];
+    [sprite removeFromParentAndCleanup:NO];
+    removeEmptyAutoBatchNode(batchNode);
+    [sprite setDisplayFrame:frame];
+    [autoBatchNode(parent, sprite, z) addChild:sprite];
+}
+
 -(float) widthInM
 {
     return [ccNode contentSize].width / PTM_RATIO;
@@ -174,14 +467,24 @@
 -(void) setLinearDamping:(float)linearDamping
 {
     body->SetLinearDamping(linearDamping);    
+    
+    if(gb2Journal)
+    {
+        gb2Journal->recordFloatOp(kGB2JournalLinearDamping, nodeId, linearDamping);
+    }
 }
 
 -(void) setAngularDamping:(float)angularDamping
 {
     body->SetAngularDamping(angularDamping);    
+    
+    if(gb2Journal)
+    {
+        gb2Journal->recordFloatOp(kGB2JournalAngularDamping, nodeId, angularDamping);
+    }
 }
 
--(void) setBodyShape:(NSString*)shapeName
+-(void) setBodyShape:(NSString*)aShapeName
 {
     b2Fixture *f;
     while((f = body->GetFixtureList()))
@@ -189,23 +492,54 @@
         body->DestroyFixture(f);        
     }
     
+    [aShapeName retain];
+    [shapeName release];
+    shapeName = aShapeName;
+    
+    if(gb2Journal)
+    {
+        gb2Journal->recordShape(nodeId, [shapeName UTF8String], shapeScale);
+    }
+    
+    minExtent = 0.0f;
+    shapeLOD = kGB2ShapeLODFull;
+    shapeFixtures = 0;
     if(shapeName)
     {
         GB2ShapeCache *shapeCache = [GB2ShapeCache sharedShapeCache];
-        [shapeCache addFixturesToBody:body forShapeName:shapeName];
+        shapeFixtures = [shapeCache addFixturesToBody:body forShapeName:shapeName scale:shapeScale lod:kGB2ShapeLODFull];
         ccNode.anchorPoint = [shapeCache anchorPointForShape:shapeName];        
+        minExtent = [shapeCache minExtentForShape:shapeName] * shapeScale;
     }
+    lodFixtures = shapeFixtures;
 }
 
 -(void) setScale:(float)scale
 {
-    // currently only graphics
     ccNode.scale = scale;
+    
+    if(scale > 0.0f && scale != shapeScale)
+    {
+        // scales in the same cache step use the same fixtures
+        bool sameShape = GB2ShapeLibrary::quantizeScale(scale) == GB2ShapeLibrary::quantizeScale(shapeScale);
+        shapeScale = scale;
+        
+        // rebuild the fixtures from the scaled shape
+        if(body && shapeName && !sameShape)
+        {
+            [self setBodyShape:shapeName];
+        }
+        else if(shapeName)
+        {
+            minExtent = [[GB2ShapeCache sharedShapeCache] minExtentForShape:shapeName] * shapeScale;
+        }
+    }
 }
 
 
 -(b2Fixture*) addFixture:(b2FixtureDef*)fixtureDef
 {
+    journalFixture(nodeId, *fixtureDef);
     return body->CreateFixture(fixtureDef);
 }
 
@@ -219,6 +553,8 @@
 
 -(void) clrCollisionMaskBits:(uint16)bits forId:(NSString*)fixtureId
 {
+    journalFilterBits(nodeId, kGB2JournalClrMask, bits, fixtureId);
+    
     b2Fixture *f = body->GetFixtureList();
     while(f)
     {
@@ -234,6 +570,8 @@
 
 -(void) addCollisionMaskBits:(uint16)bits forId:(NSString*)fixtureId
 {
+    journalFilterBits(nodeId, kGB2JournalAddMask, bits, fixtureId);
+    
     b2Fixture *f = body->GetFixtureList();
     while(f)
     {
@@ -249,6 +587,8 @@
 
 -(void) setCollisionMaskBits:(uint16)bits forId:(NSString*)fixtureId
 {
+    journalFilterBits(nodeId, kGB2JournalSetMask, bits, fixtureId);
+    
     b2Fixture *f = body->GetFixtureList();
     while(f)
     {
@@ -294,6 +634,8 @@
 
 -(void) addCollisionCategoryBits:(uint16)bits forId:(NSString*)fixtureId
 {
+    journalFilterBits(nodeId, kGB2JournalAddCategory, bits, fixtureId);
+    
     b2Fixture *f = body->GetFixtureList();
     while(f)
     {
@@ -309,6 +651,8 @@
 
 -(void) clrCollisionCategoryBits:(uint16)bits forId:(NSString*)fixtureId
 {
+    journalFilterBits(nodeId, kGB2JournalClrCategory, bits, fixtureId);
+    
     b2Fixture *f = body->GetFixtureList();
     while(f)
     {
@@ -324,6 +668,8 @@
 
 -(void) setCollisionCategoryBits:(uint16)bits forId:(NSString*)fixtureId
 {
+    journalFilterBits(nodeId, kGB2JournalSetCategory, bits, fixtureId);
+    
     b2Fixture *f = body->GetFixtureList();
     while(f)
     {
@@ -365,18 +711,33 @@
 {
     assert(body);
     body->SetFixedRotation(fixedRotation);
+    
+    if(gb2Journal)
+    {
+        gb2Journal->recordFlagOp(kGB2JournalFixedRotation, nodeId, fixedRotation);
+    }
 }
 
 -(void) setLinearVelocity:(b2Vec2)velocity
 {
     assert(body);
     body->SetLinearVelocity(velocity);
+    
+    if(gb2Journal)
+    {
+        gb2Journal->recordVec2Op(kGB2JournalLinearVelocity, nodeId, velocity);
+    }
 }
 
 -(void) applyLinearImpulse:(b2Vec2)impulse point:(b2Vec2)point 
 {
     assert(body);
     body->ApplyLinearImpulse(impulse, point);
+    
+    if(gb2Journal)
+    {
+        gb2Journal->recordVec2PairOp(kGB2JournalLinearImpulse, nodeId, impulse, point);
+    }
 }
 
 -(b2Vec2) physicsPosition
@@ -400,6 +761,11 @@
 {
     assert(body);
     body->SetType(bodyType);
+    
+    if(gb2Journal)
+    {
+        gb2Journal->recordBodyType(nodeId, bodyType);
+    }
 }
 
 -(BOOL) isAwake
@@ -411,6 +777,11 @@
 {
     assert(body);
     body->ApplyForce(force, point);
+    
+    if(gb2Journal)
+    {
+        gb2Journal->recordVec2PairOp(kGB2JournalForce, nodeId, force, point);
+    }
 }
 
 -(float) angle
@@ -423,11 +794,76 @@
 {
     assert(body);
     body->SetTransform(pos, angle);
+    journalTransform(nodeId, body);
+}
+
+-(void) moveTo:(b2Vec2)position duration:(float)duration
+{
+    [self moveTo:position duration:duration ease:kGB2EaseLinear];
+}
+
+-(void) moveTo:(b2Vec2)position duration:(float)duration ease:(GB2MotionEase)ease
+{
+    assert(body);
+    kinematics()->moveTo(body, position, duration, ease);
+}
+
+-(void) moveBy:(b2Vec2)delta duration:(float)duration
+{
+    assert(body);
+    kinematics()->moveBy(body, delta, duration);
+}
+
+-(void) rotateTo:(float)angle duration:(float)duration
+{
+    assert(body);
+    kinematics()->rotateTo(body, angle, duration);
+}
+
+-(void) rotateBy:(float)angle duration:(float)duration
+{
+    assert(body);
+    kinematics()->rotateBy(body, angle, duration);
+}
+
+-(void) followPath:(const b2Vec2*)points count:(int)count speed:(float)speed loop:(BOOL)loop
+{
+    assert(body);
+    kinematics()->followPath(body, points, count, speed, loop);
+}
+
+-(BOOL) isTouchingClass:(Class)cls
+{
+    return [[GB2Engine sharedInstance] object:self isTouchingClass:cls];
+}
+
+-(BOOL) isTouchingFixtureId:(NSString*)fixtureId
+{
+    return [[GB2Engine sharedInstance] object:self isTouchingFixtureId:fixtureId];
+}
+
+-(NSArray*) touchingNodes
+{
+    return [[GB2Engine sharedInstance] objectsTouching:self];
+}
+
+-(void) stopMotion
+{
+    if(body)
+    {
+        kinematics()->stop(body);
+    }
+}
+
+-(BOOL) isMoving
+{
+    return body && kinematics()->isMoving(body);
 }
 
 -(void) setAngle:(float)angle
 {
     body->SetTransform(body->GetWorldCenter(), angle);
+    journalTransform(nodeId, body);
 }
 
 -(void) setPhysicsPosition:(b2Vec2)pos
@@ -435,6 +871,7 @@
     assert(body);
     ccNode.position = CGPointFromb2Vec2(pos);
     body->SetTransform(pos, body->GetAngle());
+    journalTransform(nodeId, body);
 }
 
 -(void)setCcPosition:(CGPoint)pos
@@ -442,6 +879,7 @@
     assert(body);
     ccNode.position = pos;
     body->SetTransform(b2Vec2FromCGPoint(pos), body->GetAngle());
+    journalTransform(nodeId, body);
 }
 
 -(CGPoint)ccPosition
@@ -457,6 +895,11 @@
 -(void) setActive:(bool)isActive
 {
     body->SetActive(isActive);    
+    
+    if(gb2Journal)
+    {
+        gb2Journal->recordFlagOp(kGB2JournalActive, nodeId, isActive);
+    }
 }
 
 -(bool) awake
@@ -477,10 +920,139 @@
 -(void) setBullet:(bool)bulletFlag
 {
     body->SetBullet(bulletFlag);
+    manualBullet = true;
+    
+    if(gb2Journal)
+    {
+        gb2Journal->recordFlagOp(kGB2JournalBullet, nodeId, bulletFlag);
+    }
+}
+
+-(void) setAutomaticBullet
+{
+    manualBullet = false;
+}
+
+-(bool) updateBulletForTimeStep:(float)timeStep fraction:(float)fraction
+{
+    if(!body || manualBullet || minExtent <= 0.0f || body->GetType() != b2_dynamicBody)
+    {
+        return body && body->IsBullet();
+    }
+    
+    bool bullet = false;
+    if(body->IsAwake())
+    {
+        // compare squared distances to avoid the square root
+        float32 maxDistance = fraction * minExtent;
+        b2Vec2 displacement = timeStep * body->GetLinearVelocity();
+        bullet = displacement.LengthSquared() > maxDistance * maxDistance;
+    }
+    
+    if(bullet != body->IsBullet())
+    {
+        body->SetBullet(bullet);
+        
+        if(gb2Journal)
+        {
+            gb2Journal->recordFlagOp(kGB2JournalBullet, nodeId, bullet);
+        }
+    }
+    return bullet;
+}
+
+-(GB2ShapeLOD) shapeLOD
+{
+    return shapeLOD;
+}
+
+-(void) setShapeLOD:(GB2ShapeLOD)lod
+{
+    // the journal replays full shapes only
+    if(lod == shapeLOD || !body || !shapeName || (gb2Journal && lod != kGB2ShapeLODFull))
+    {
+        return;
+    }
+    
+    b2MassData massData;
+    body->GetMassData(&massData);
+    
+    // filters per fixture id, merged fixtures share the id
+    std::vector< std::pair<void*, b2Filter> > filters;
+    b2Fixture *f;
+    while((f = body->GetFixtureList()))
+    {
+        filters.push_back(std::make_pair(f->GetUserData(), f->GetFilterData()));
+        body->DestroyFixture(f);
+    }
+    
+    GB2ShapeCache *shapeCache = [GB2ShapeCache sharedShapeCache];
+    lodFixtures = [shapeCache addFixturesToBody:body forShapeName:shapeName scale:shapeScale lod:lod];
+    shapeLOD = lod;
+    
+    for(f = body->GetFixtureList(); f; f = f->GetNext())
+    {
+        for(size_t i=0; i<filters.size(); i++)
+        {
+            if(filters[i].first == f->GetUserData())
+            {
+                if(!sameFilter(filters[i].second, f->GetFilterData()))
+                {
+                    f->SetFilterData(filters[i].second);
+                }
+                break;
+            }
+        }
+    }
+    
+    // coarse fixtures have a different mass
+    if(body->GetType() == b2_dynamicBody)
+    {
+        body->SetMassData(&massData);
+    }
+}
+
+-(bool) updateShapeLODWithCenter:(b2Vec2)center distances:(const float*)distances hysteresis:(float)hysteresis
+{
+    if(!body || !shapeName)
+    {
+        return false;
+    }
+    
+    // objects with fixtures added to the shape keep their fixtures
+    int fixtures = 0;
+    for(b2Fixture *f = body->GetFixtureList(); f; f = f->GetNext())
+    {
+        fixtures++;
+    }
+    if(fixtures != lodFixtures)
+    {
+        return false;
+    }
+    
+    GB2ShapeLOD lod = kGB2ShapeLODFull;
+    if(!gb2Journal)
+    {
+        float distance = distanceToFixtures(body, center);
+        lod = lodForDistance(distance, shapeLOD, distances, hysteresis);
+    }
+    
+    if(lod == shapeLOD)
+    {
+        return false;
+    }
+    [self setShapeLOD:lod];
+    return true;
+}
+
+-(int) fixturesSavedByLOD
+{
+    return shapeFixtures - lodFixtures;
 }
 
 -(b2Fixture*) createFixture:(const b2FixtureDef*)fixtureDef
 {
+    journalFixture(nodeId, *fixtureDef);
     return body->CreateFixture(fixtureDef);
 }
 
@@ -491,12 +1063,24 @@
 
 -(void) setObjectTag:(int)aTag
 {
+    int oldTag = objectTag;
     objectTag = aTag;
+    
+    // only objects with a body are indexed
+    if(body)
+    {
+        [[GB2Engine sharedInstance] object:self changedTagFrom:oldTag];
+    }
 }
 
 -(void) setAngularVelocity:(float32)v
 {
     body->SetAngularVelocity(v);
+    
+    if(gb2Journal)
+    {
+        gb2Journal->recordFloatOp(kGB2JournalAngularVelocity, nodeId, v);
+    }
 }
 
 -(void)setVisible:(BOOL)isVisible
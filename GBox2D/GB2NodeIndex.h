@@ -0,0 +1,97 @@
+/*
+ MIT License
+ 
+ Copyright (c) 2010 Andreas Loew / www.code-and-web.de
+ 
+ For more information about htis module visit
+ http://www.PhysicsEditor.de
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+#import <map>
+#import <vector>
+
+#pragma once
+
+@class GB2Node;
+
+/**
+ * List of objects in an index bucket
+ */
+typedef std::vector<GB2Node*> GB2NodeList;
+
+/**
+ * GB2NodeIndex
+ *
+ * Index of the GB2Nodes by tag and by class
+ *
+ * Maintained by GB2Engine. The objects are not retained - they
+ * are removed when their body is destroyed. Tag 0 is the default
+ * tag of all objects and is not indexed.
+ *
+ * Removing reorders a list. Iterations work on a copy of the list
+ * and skip the objects removed since beginIteration().
+ */
+class GB2NodeIndex
+{
+public:
+    GB2NodeIndex()
+    : iterating(0)
+    {}
+    
+    void add(GB2Node *node, Class nodeClass, int tag);
+    void remove(GB2Node *node, Class nodeClass, int tag);
+    void changeTag(GB2Node *node, int oldTag, int newTag);
+    void clear();
+    
+    /**
+     * Returns the objects with the tag, NULL if there are none
+     */
+    const GB2NodeList *nodesWithTag(int tag) const;
+    
+    /**
+     * Returns the objects of exactly this class, NULL if there are none
+     */
+    const GB2NodeList *nodesOfClass(Class nodeClass) const;
+    
+    /**
+     * Returns the buckets of all classes
+     */
+    const std::map<Class, GB2NodeList> &classBuckets() const { return classes; }
+    
+    /**
+     * Starts and ends collecting the removed objects,
+     * iterations might be nested
+     */
+    void beginIteration();
+    void endIteration();
+    
+    /**
+     * Returns true if the object was removed since beginIteration()
+     */
+    bool removedDuringIteration(GB2Node *node) const;
+    
+private:
+    std::map<int, GB2NodeList> tags;
+    std::map<Class, GB2NodeList> classes;
+    int iterating;
+    GB2NodeList removed;
+};
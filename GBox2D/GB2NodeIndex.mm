@@ -0,0 +1,128 @@
+/*
+ MIT License
+ 
+ Copyright (c) 2010 Andreas Loew / www.code-and-web.de
+ 
+ For more information about htis module visit
+ http://www.PhysicsEditor.de
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import <algorithm>
+#import "GB2NodeIndex.h"
+
+/**
+ * Removes the node from the list without keeping the order
+ */
+static void removeFromList(GB2NodeList &list, GB2Node *node)
+{
+    // recently added objects are removed more often - search from the back
+    GB2NodeList::reverse_iterator it = std::find(list.rbegin(), list.rend(), node);
+    if(it != list.rend())
+    {
+        *it = list.back();
+        list.pop_back();
+    }
+}
+
+void GB2NodeIndex::add(GB2Node *node, Class nodeClass, int tag)
+{
+    classes[nodeClass].push_back(node);
+    if(tag)
+    {
+        tags[tag].push_back(node);
+    }
+}
+
+void GB2NodeIndex::remove(GB2Node *node, Class nodeClass, int tag)
+{
+    std::map<Class, GB2NodeList>::iterator it = classes.find(nodeClass);
+    if(it != classes.end())
+    {
+        removeFromList(it->second, node);
+    }
+    changeTag(node, tag, 0);
+    
+    if(iterating)
+    {
+        removed.push_back(node);
+    }
+}
+
+void GB2NodeIndex::changeTag(GB2Node *node, int oldTag, int newTag)
+{
+    if(oldTag == newTag)
+    {
+        return;
+    }
+    if(oldTag)
+    {
+        std::map<int, GB2NodeList>::iterator it = tags.find(oldTag);
+        if(it != tags.end())
+        {
+            removeFromList(it->second, node);
+            if(it->second.empty())
+            {
+                tags.erase(it);
+            }
+        }
+    }
+    if(newTag)
+    {
+        tags[newTag].push_back(node);
+    }
+}
+
+void GB2NodeIndex::clear()
+{
+    tags.clear();
+    classes.clear();
+}
+
+const GB2NodeList *GB2NodeIndex::nodesWithTag(int tag) const
+{
+    std::map<int, GB2NodeList>::const_iterator it = tags.find(tag);
+    return (it != tags.end()) ? &it->second : 0;
+}
+
+const GB2NodeList *GB2NodeIndex::nodesOfClass(Class nodeClass) const
+{
+    std::map<Class, GB2NodeList>::const_iterator it = classes.find(nodeClass);
+    return (it != classes.end()) ? &it->second : 0;
+}
+
+void GB2NodeIndex::beginIteration()
+{
+    iterating++;
+}
+
+void GB2NodeIndex::endIteration()
+{
+    if(--iterating == 0)
+    {
+        removed.clear();
+    }
+}
+
+bool GB2NodeIndex::removedDuringIteration(GB2Node *node) const
+{
+    // only a few objects are destroyed during an iteration
+    return std::find(removed.begin(), removed.end(), node) != removed.end();
+}
@@ -0,0 +1,288 @@
+/*
+ MIT License
+ 
+ Copyright (c) 2010 Andreas Loew / www.code-and-web.de
+ 
+ For more information about htis module visit
+ http://www.PhysicsEditor.de
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "GB2Plist.h"
+
+/**
+ * Internal recursive descent parser for XML property lists
+ */
+class GB2PlistParser
+{
+public:
+    GB2PlistParser(const char *aData, size_t aSize)
+    : data(aData)
+    , end(aData + aSize)
+    {}
+    
+    bool parse(GB2PlistValue &root)
+    {
+        std::string tag;
+        
+        // skip everything up to the plist element
+        do
+        {
+            if(!nextTag(tag))
+            {
+                return false;
+            }
+        }
+        while(tag.compare(0, 5, "plist") != 0);
+        
+        if(!nextTag(tag))
+        {
+            return false;
+        }
+        return parseValue(tag, root);
+    }
+    
+private:
+    /**
+     * Reads the next element tag, skipping text, comments,
+     * processing instructions and doctype declarations
+     */
+    bool nextTag(std::string &tag)
+    {
+        for(;;)
+        {
+            while(data < end && *data != '<')
+            {
+                data++;
+            }
+            if(data >= end)
+            {
+                return false;
+            }
+            
+            if(startsWith("<!--"))
+            {
+                const char *close = find("-->");
+                if(!close)
+                {
+                    return false;
+                }
+                data = close + 3;
+                continue;
+            }
+            
+            const char *close = (const char*)memchr(data, '>', end - data);
+            if(!close)
+            {
+                return false;
+            }
+            
+            if(data[1] == '?' || data[1] == '!')
+            {
+                data = close + 1;
+                continue;
+            }
+            
+            tag.assign(data + 1, close - data - 1);
+            data = close + 1;
+            return true;
+        }
+    }
+    
+    /**
+     * Reads the text up to the closing tag
+     */
+    bool readText(const char *closingTag, std::string &text)
+    {
+        const char *close = find(closingTag);
+        if(!close)
+        {
+            return false;
+        }
+        unescape(data, close, text);
+        data = close + strlen(closingTag);
+        return true;
+    }
+    
+    bool parseValue(const std::string &tag, GB2PlistValue &value)
+    {
+        // empty elements like <true/> or <string/>
+        bool empty = !tag.empty() && tag[tag.size()-1] == '/';
+        std::string name = empty ? tag.substr(0, tag.size()-1) : tag;
+        
+        if(name == "true" || name == "false")
+        {
+            value.type = GB2PlistValue::kBool;
+            value.number = (name == "true") ? 1.0 : 0.0;
+            if(!empty)
+            {
+                std::string ignored;
+                return readText(name == "true" ? "</true>" : "</false>", ignored);
+            }
+            return true;
+        }
+        
+        if(name == "string" || name == "real" || name == "integer")
+        {
+            value.type = (name == "string") ? GB2PlistValue::kString
+                       : (name == "real") ? GB2PlistValue::kReal : GB2PlistValue::kInteger;
+            if(!empty && !readText(("</" + name + ">").c_str(), value.string))
+            {
+                return false;
+            }
+            value.number = strtod(value.string.c_str(), 0);
+            return true;
+        }
+        
+        if(name == "array" || name == "dict")
+        {
+            bool dict = (name == "dict");
+            value.type = dict ? GB2PlistValue::kDict : GB2PlistValue::kArray;
+            if(empty)
+            {
+                return true;
+            }
+            
+            std::string childTag;
+            for(;;)
+            {
+                if(!nextTag(childTag))
+                {
+                    return false;
+                }
+                if(childTag[0] == '/')
+                {
+                    return true;
+                }
+                
+                if(dict)
+                {
+                    if(childTag != "key")
+                    {
+                        return false;
+                    }
+                    std::string key;
+                    if(!readText("</key>", key) || !nextTag(childTag))
+                    {
+                        return false;
+                    }
+                    value.keys.push_back(key);
+                }
+                
+                value.values.push_back(GB2PlistValue());
+                if(!parseValue(childTag, value.values.back()))
+                {
+                    return false;
+                }
+            }
+        }
+        
+        // unsupported element (data, date) - skip its content
+        if(!empty)
+        {
+            std::string ignored;
+            return readText(("</" + name + ">").c_str(), ignored);
+        }
+        return true;
+    }
+    
+    bool startsWith(const char *s) const
+    {
+        size_t length = strlen(s);
+        return (size_t)(end - data) >= length && memcmp(data, s, length) == 0;
+    }
+    
+    const char *find(const char *s) const
+    {
+        size_t length = strlen(s);
+        for(const char *p = data; p + length <= end; p++)
+        {
+            if(memcmp(p, s, length) == 0)
+            {
+                return p;
+            }
+        }
+        return 0;
+    }
+    
+    static void unescape(const char *begin, const char *stop, std::string &text)
+    {
+        static const struct { const char *entity; char c; } entities[] = {
+            { "&lt;", '<' }, { "&gt;", '>' }, { "&amp;", '&' }, { "&quot;", '"' }, { "&apos;", '\'' }
+        };
+        
+        text.clear();
+        for(const char *p = begin; p < stop; p++)
+        {
+            bool replaced = false;
+            if(*p == '&')
+            {
+                for(size_t i=0; i<sizeof(entities)/sizeof(entities[0]); i++)
+                {
+                    size_t length = strlen(entities[i].entity);
+                    if((size_t)(stop - p) >= length && memcmp(p, entities[i].entity, length) == 0)
+                    {
+                        text += entities[i].c;
+                        p += length - 1;
+                        replaced = true;
+                        break;
+                    }
+                }
+            }
+            if(!replaced)
+            {
+                text += *p;
+            }
+        }
+    }
+    
+    const char *data;
+    const char *end;
+};
+
+const GB2PlistValue *GB2PlistValue::objectForKey(const char *key) const
+{
+    if(type != kDict)
+    {
+        return 0;
+    }
+    for(size_t i=0; i<keys.size(); i++)
+    {
+        if(keys[i] == key)
+        {
+            return &values[i];
+        }
+    }
+    return 0;
+}
+
+double GB2PlistValue::doubleValue() const
+{
+    return number;
+}
+
+bool GB2ParsePlist(const char *data, size_t size, GB2PlistValue &root)
+{
+    root = GB2PlistValue();
+    GB2PlistParser parser(data, size);
+    return parser.parse(root);
+}
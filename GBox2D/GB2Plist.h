@@ -0,0 +1,105 @@
+/*
+ MIT License
+ 
+ Copyright (c) 2010 Andreas Loew / www.code-and-web.de
+ 
+ For more information about htis module visit
+ http://www.PhysicsEditor.de
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#include <string>
+#include <vector>
+
+#pragma once
+
+/**
+ * GB2PlistValue
+ *
+ * A value of a property list
+ *
+ * Minimal portable replacement for the Foundation plist
+ * classes - used to read the PhysicsEditor shape files
+ * without Foundation.
+ */
+class GB2PlistValue
+{
+public:
+    enum Type
+    {
+        kNone,
+        kDict,
+        kArray,
+        kString,
+        kReal,
+        kInteger,
+        kBool
+    };
+    
+    GB2PlistValue()
+    : type(kNone)
+    , number(0.0)
+    {}
+    
+    /**
+     * Returns the value for the key, NULL if the value is not
+     * a dictionary or the key does not exist
+     */
+    const GB2PlistValue *objectForKey(const char *key) const;
+    
+    /**
+     * Returns the number of elements of an array or dictionary
+     */
+    size_t count() const { return values.size(); }
+    
+    /**
+     * Returns the element at the index of an array or dictionary
+     */
+    const GB2PlistValue &objectAtIndex(size_t index) const { return values[index]; }
+    
+    /**
+     * Returns the key at the index of a dictionary
+     */
+    const std::string &keyAtIndex(size_t index) const { return keys[index]; }
+    
+    /**
+     * Returns the value converted to a number
+     * Strings are parsed, missing values return 0
+     */
+    double doubleValue() const;
+    float floatValue() const { return (float)doubleValue(); }
+    int intValue() const { return (int)doubleValue(); }
+    bool boolValue() const { return doubleValue() != 0.0; }
+    
+    Type type;
+    std::string string;                 //!< value of strings
+    double number;                      //!< value of numbers and bools
+    std::vector<std::string> keys;      //!< keys of a dictionary
+    std::vector<GB2PlistValue> values;  //!< elements of an array or dictionary
+};
+
+/**
+ * Parses an XML property list
+ * @param data xml data
+ * @param size size of the data
+ * @param root receives the root value
+ * @return true on success
+ */
+bool GB2ParsePlist(const char *data, size_t size, GB2PlistValue &root);
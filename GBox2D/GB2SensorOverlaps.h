@@ -0,0 +1,124 @@
+/*
+ MIT License
+ 
+ Copyright (c) 2010 Andreas Loew / www.code-and-web.de
+ 
+ For more information about htis module visit
+ http://www.PhysicsEditor.de
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+#import <map>
+#import <vector>
+#import "Box2D.h"
+
+#pragma once
+
+@class GB2Node;
+
+/**
+ * Object overlapping a sensor
+ */
+struct GB2SensorOccupant
+{
+    GB2Node *node;          //!< the overlapping object
+    int32 contacts;         //!< number of touching fixture contacts
+};
+
+/**
+ * GB2SensorOverlaps
+ *
+ * Overlap sets of sensor objects with batched enter and exit events
+ *
+ * A sensor object takes part if it implements
+ *   -(void) sensorEntered:(NSArray*)entered exited:(NSArray*)exited;
+ * Begin and end contacts of its sensor fixtures only update the
+ * overlap set of the object. Once per step dispatch() calls the
+ * selector with the objects which entered and left since the
+ * last call. An object entering and leaving within the same step
+ * is not reported.
+ *
+ * Contacts with these sensors don't call the notifyObjects
+ * selectors - neither on the sensor nor on the other object.
+ *
+ * Destroyed objects leave the overlap sets without an exit event,
+ * also if they are destroyed by a sensorEntered:exited: callback.
+ */
+class GB2SensorOverlaps
+{
+public:
+    /**
+     * Updates the overlap sets from a contact
+     * Contacts with bodies without an object are not counted.
+     * @return true if the contact was counted for a batched sensor
+     *         and must not be dispatched to the objects
+     */
+    bool beginContact(b2Contact *contact);
+    bool endContact(b2Contact *contact);
+    
+    /**
+     * Calls the sensors with the changes since the last call
+     */
+    void dispatch();
+    
+    /**
+     * Removes a destroyed object from all sets and pending events
+     */
+    void removeNode(GB2Node *node);
+    
+    /**
+     * Drops all sets and pending events
+     */
+    void clear();
+    
+    /**
+     * Adds the touching contacts of a world, used when the sets are
+     * attached to a running world. The sensors receive the current
+     * occupants as entered objects with the next dispatch().
+     */
+    void addTouchingContacts(b2World *world);
+    
+    /**
+     * Returns the current occupants of a sensor, NULL if the
+     * sensor has none yet
+     */
+    const std::vector<GB2SensorOccupant> *occupants(GB2Node *sensor) const;
+    
+private:
+    struct Sensor
+    {
+        Sensor()
+        : dirty(false)
+        {}
+        
+        std::vector<GB2SensorOccupant> occupants;
+        std::vector<GB2Node*> entered;
+        std::vector<GB2Node*> exited;
+        bool dirty;
+    };
+    
+    bool update(b2Contact *contact, bool begin);
+    bool change(GB2Node *sensorNode, GB2Node *other, bool begin);
+    
+    std::map<GB2Node*, Sensor> sensors;
+    std::vector<GB2Node*> dirtySensors;
+    std::vector<GB2Node*> dispatching;      // sensors taken by dispatch()
+};
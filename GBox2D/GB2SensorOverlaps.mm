@@ -0,0 +1,251 @@
+/*
+ MIT License
+ 
+ Copyright (c) 2010 Andreas Loew / www.code-and-web.de
+ 
+ For more information about htis module visit
+ http://www.PhysicsEditor.de
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import <algorithm>
+#import "GB2SensorOverlaps.h"
+#import "GB2Node.h"
+
+/**
+ * Removes an element from a list without keeping the order
+ * @return true if the element was found
+ */
+static bool removeFromList(std::vector<GB2Node*> &list, GB2Node *node)
+{
+    std::vector<GB2Node*>::iterator it = std::find(list.begin(), list.end(), node);
+    if(it == list.end())
+    {
+        return false;
+    }
+    *it = list.back();
+    list.pop_back();
+    return true;
+}
+
+/**
+ * Returns true if the fixture is a sensor of an object
+ * using the batched events
+ */
+static inline bool isBatchedSensor(b2Fixture *fixture, GB2Node *owner)
+{
+    return fixture->IsSensor() && [owner respondsToSelector:@selector(sensorEntered:exited:)];
+}
+
+bool GB2SensorOverlaps::beginContact(b2Contact *contact)
+{
+    return update(contact, true);
+}
+
+bool GB2SensorOverlaps::endContact(b2Contact *contact)
+{
+    return update(contact, false);
+}
+
+bool GB2SensorOverlaps::update(b2Contact *contact, bool begin)
+{
+    b2Fixture *fixtureA = contact->GetFixtureA();
+    b2Fixture *fixtureB = contact->GetFixtureB();
+    GB2Node *a = (GB2Node *)fixtureA->GetBody()->GetUserData();
+    GB2Node *b = (GB2Node *)fixtureB->GetBody()->GetUserData();
+    if(!a || !b)
+    {
+        return false;
+    }
+    
+    bool handled = false;
+    if(isBatchedSensor(fixtureA, a))
+    {
+        handled |= change(a, b, begin);
+    }
+    if(isBatchedSensor(fixtureB, b))
+    {
+        handled |= change(b, a, begin);
+    }
+    return handled;
+}
+
+/**
+ * Counts a begin or end contact of the sensor
+ * @return false for the end of a contact which was not counted
+ */
+bool GB2SensorOverlaps::change(GB2Node *sensorNode, GB2Node *other, bool begin)
+{
+    Sensor &sensor = sensors[sensorNode];
+    
+    // find the occupant - the sets are small, a linear search is fast
+    size_t i = 0;
+    while(i < sensor.occupants.size() && sensor.occupants[i].node != other)
+    {
+        i++;
+    }
+    
+    if(begin)
+    {
+        if(i < sensor.occupants.size())
+        {
+            // another fixture of the object touches the sensor
+            sensor.occupants[i].contacts++;
+            return true;
+        }
+        GB2SensorOccupant occupant = { other, 1 };
+        sensor.occupants.push_back(occupant);
+        
+        // leaving and entering again in the same step is no change
+        if(!removeFromList(sensor.exited, other))
+        {
+            sensor.entered.push_back(other);
+        }
+    }
+    else
+    {
+        if(i == sensor.occupants.size())
+        {
+            // the contact began before the sets were attached
+            return false;
+        }
+        if(--sensor.occupants[i].contacts > 0)
+        {
+            return true;
+        }
+        sensor.occupants[i] = sensor.occupants.back();
+        sensor.occupants.pop_back();
+        
+        if(!removeFromList(sensor.entered, other))
+        {
+            sensor.exited.push_back(other);
+        }
+    }
+    
+    if(!sensor.dirty)
+    {
+        sensor.dirty = true;
+        dirtySensors.push_back(sensorNode);
+    }
+    return true;
+}
+
+/**
+ * Creates an array with the objects of a list
+ */
+static NSArray *arrayWithNodes(const std::vector<GB2Node*> &nodes)
+{
+    if(nodes.empty())
+    {
+        return [NSArray array];
+    }
+    return [NSArray arrayWithObjects:(id*)&nodes[0] count:nodes.size()];
+}
+
+void GB2SensorOverlaps::dispatch()
+{
+    if(dirtySensors.empty())
+    {
+        return;
+    }
+    
+    // the callbacks might destroy objects or change the sets,
+    // removeNode() purges destroyed objects from the taken sensors too
+    dispatching.swap(dirtySensors);
+    
+    for(size_t i=0; i<dispatching.size(); i++)
+    {
+        GB2Node *sensorNode = dispatching[i];
+        std::map<GB2Node*, Sensor>::iterator it = sensors.find(sensorNode);
+        if(it == sensors.end())
+        {
+            // the sensor was destroyed by an earlier callback
+            continue;
+        }
+        
+        Sensor &sensor = it->second;
+        sensor.dirty = false;
+        if(sensor.entered.empty() && sensor.exited.empty())
+        {
+            continue;
+        }
+        
+        NSArray *entered = arrayWithNodes(sensor.entered);
+        NSArray *exited = arrayWithNodes(sensor.exited);
+        sensor.entered.clear();
+        sensor.exited.clear();
+        
+        [sensorNode performSelector:@selector(sensorEntered:exited:) withObject:entered withObject:exited];
+    }
+    dispatching.clear();
+}
+
+void GB2SensorOverlaps::removeNode(GB2Node *node)
+{
+    std::map<GB2Node*, Sensor>::iterator it = sensors.find(node);
+    if(it != sensors.end())
+    {
+        if(it->second.dirty)
+        {
+            removeFromList(dirtySensors, node);
+        }
+        sensors.erase(it);
+    }
+    
+    // destroying the body ended its contacts - drop the pending events
+    // of the dirty sensors and of the sensors not yet dispatched
+    const std::vector<GB2Node*> *lists[2] = { &dirtySensors, &dispatching };
+    for(int l=0; l<2; l++)
+    {
+        for(size_t i=0; i<lists[l]->size(); i++)
+        {
+            std::map<GB2Node*, Sensor>::iterator sensor = sensors.find((*lists[l])[i]);
+            if(sensor != sensors.end())
+            {
+                removeFromList(sensor->second.entered, node);
+                removeFromList(sensor->second.exited, node);
+            }
+        }
+    }
+}
+
+void GB2SensorOverlaps::clear()
+{
+    sensors.clear();
+    dirtySensors.clear();
+    dispatching.clear();
+}
+
+void GB2SensorOverlaps::addTouchingContacts(b2World *world)
+{
+    for(b2Contact *contact = world->GetContactList(); contact; contact = contact->GetNext())
+    {
+        if(contact->IsTouching())
+        {
+            update(contact, true);
+        }
+    }
+}
+
+const std::vector<GB2SensorOccupant> *GB2SensorOverlaps::occupants(GB2Node *sensor) const
+{
+    std::map<GB2Node*, Sensor>::const_iterator it = sensors.find(sensor);
+    return (it != sensors.end()) ? &it->second.occupants : 0;
+}
@@ -33,26 +33,62 @@
 
 #import <Foundation/Foundation.h>
 #import <Box2D.h>
+#import "GB2ShapeLibrary.h"
+
+/**
+ * Type for block callbacks with fixture definitions
+ * Used in iterateFixturesForShapeName:withBlock:
+ */
+typedef void(^GB2FixtureDefCallBack)(const b2FixtureDef *fixtureDef);
+
+/**
+ * Type for block callbacks with the memory usage of a shape
+ * Used in iterateMemoryUsageWithBlock:
+ */
+typedef void(^GB2ShapeMemoryCallBack)(NSString *shape, int fixtures, size_t bytes);
 
 /**
  * Shape cache 
  * This class holds the shapes and makes them accessible 
  * The format can be used on any MacOS/iOS system
+ *
+ * The shapes are stored in a GB2ShapeLibrary, this class
+ * loads the files from the bundle and sets NSStrings with
+ * the fixture ids as fixture user data.
  */
 @interface GB2ShapeCache : NSObject 
 {
-    NSMutableDictionary *shapeObjects_;
-    float ptmRatio_;
+    GB2ShapeLibrary *library_;
 }
 
 + (GB2ShapeCache *)sharedShapeCache;
 
+/**
+ * Returns the portable shape library holding the shapes
+ */
+-(GB2ShapeLibrary*) library;
+
 /**
  * Adds shapes to the shape cache
  * @param plist name of the plist file to load
  */
 -(void) addShapesWithFile:(NSString*)plist;
 
+/**
+ * Parses a shapes file without adding it to the shape cache
+ * This method does not modify the cache and can be called
+ * from a background thread.
+ * @param plist name of the plist file to load
+ * @return parsed shapes, add them with addParsedShapes: on the main thread
+ */
+-(id) parseShapesWithFile:(NSString*)plist;
+
+/**
+ * Adds shapes returned by parseShapesWithFile: to the shape cache
+ * @param parsedShapes parsed shapes
+ */
+-(void) addParsedShapes:(id)parsedShapes;
+
 /**
  * Adds fixture data to a body
  * @param body body to add the fixture to
@@ -60,6 +96,38 @@
  */
 -(void) addFixturesToBody:(b2Body*)body forShapeName:(NSString*)shape;
 
+/**
+ * Adds scaled fixture data to a body
+ * Polygon vertices, circle radius and position are scaled.
+ * The scaled fixtures are created on first use and cached per
+ * shape and scale. The scale is quantized to 1%.
+ * @param body body to add the fixture to
+ * @param shape name of the shape
+ * @param scale scale factor
+ */
+-(void) addFixturesToBody:(b2Body*)body forShapeName:(NSString*)shape scale:(float)scale;
+
+/**
+ * Adds scaled fixture data in a level of detail to a body
+ * Coarse levels merge fixtures with the same filter, sensor flag
+ * and fixture id into a convex hull, box or circle. They are
+ * created on first use and cached like scaled shapes.
+ * @param body body to add the fixture to
+ * @param shape name of the shape
+ * @param scale scale factor
+ * @param lod level of detail
+ * @return number of fixtures added
+ */
+-(int) addFixturesToBody:(b2Body*)body forShapeName:(NSString*)shape scale:(float)scale lod:(GB2ShapeLOD)lod;
+
+/**
+ * Calls the block with each fixture definition of the shape
+ * The fixture definitions and shapes are owned by the cache
+ * @param shape name of the shape
+ * @param callback block to call
+ */
+-(void) iterateFixturesForShapeName:(NSString*)shape withBlock:(GB2FixtureDefCallBack)callback;
+
 /**
  * Returns the anchor point of the given sprite
  * @param shape name of the shape to get the anchorpoint for
@@ -67,6 +135,30 @@
  */
 -(CGPoint) anchorPointForShape:(NSString*)shape;
 
+/**
+ * Returns the smallest extent of the shape's fixtures
+ * This is the smallest width of a polygon or the diameter
+ * of a circle, in physics coordinates.
+ * @param shape name of the shape
+ * @return smallest fixture extent
+ */
+-(float) minExtentForShape:(NSString*)shape;
+
+/**
+ * Calls the block with the memory used by each shape
+ * Scaled variants are reported with their cache key
+ * (name@scale in percent)
+ * @param callback block to call
+ */
+-(void) iterateMemoryUsageWithBlock:(GB2ShapeMemoryCallBack)callback;
+
+/**
+ * Returns the memory used by all cached shapes
+ * @param fixtures receives the number of cached fixtures, might be NULL
+ * @return size in bytes
+ */
+-(size_t) memoryUsage:(int*)fixtures;
+
 /**
  * Returns the ptm ratio
  */
@@ -32,70 +32,35 @@
 //
 
 #import "GB2ShapeCache.h"
-
-#if defined(__IPHONE_OS_VERSION_MIN_REQUIRED)
-#   define CGPointFromString_ CGPointFromString
-#else
-// well - not nice but works for now
-static CGPoint CGPointFromString_(NSString* str)
-{
-    NSString* theString = str;
-    theString = [theString stringByReplacingOccurrencesOfString:@"{ " withString:@""];
-    theString = [theString stringByReplacingOccurrencesOfString:@" }" withString:@""];
-    NSArray *array = [theString componentsSeparatedByString:@","];
-    return CGPointMake([[array objectAtIndex:0] floatValue], [[array objectAtIndex:1] floatValue]);
-}
-#endif
+#import "GB2ShapeLibrary.h"
+#import "GB2Trace.h"
 
 /**
- * Internal class to hold the fixtures
+ * User data of the fixtures: the fixture id as NSString
+ * The strings are kept for the lifetime of the fixtures.
  */
-class FixtureDef 
+static void *fixtureIdString(const char *fixtureId)
 {
-public:
-    FixtureDef()
-    : next(0)
-    {}
-    
-    ~FixtureDef()
-    {
-        delete next;
-        delete fixture.shape;
-    }
-    
-    FixtureDef *next;
-    b2FixtureDef fixture;
-    int callbackData;
-};
+    return [[NSString alloc] initWithUTF8String:fixtureId];
+}
 
 /**
- * Body definition
- * Holds the body and the anchor point
+ * Result of parsing a shapes file
+ * Holds the shape set until it is added to the library
  */
-@interface BodyDef : NSObject
+@interface GB2ParsedShapes : NSObject
 {
 @public
-    FixtureDef *fixtures;
-    CGPoint anchorPoint;
+    GB2ShapeSet *shapeSet;
 }
 @end
 
 
-@implementation BodyDef
-
--(id) init
-{
-    self = [super init];
-    if(self)
-    {
-        fixtures = 0;
-    }
-    return self;
-}
+@implementation GB2ParsedShapes
 
 -(void) dealloc
 {
-    delete fixtures;
+    delete shapeSet;
     [super dealloc];
 }
 
@@ -107,11 +72,13 @@ public:
 
 + (GB2ShapeCache *)sharedShapeCache
 {
+    // GB2LevelLoader parses shapes on a worker thread, the first
+    // call might not come from the main thread
     static GB2ShapeCache *shapeCache = 0;
-    if(!shapeCache)
-    {
+    static dispatch_once_t once;
+    dispatch_once(&once, ^{
         shapeCache = [[GB2ShapeCache alloc] init];
-    }
+    });
     return shapeCache;
 }
 
@@ -120,151 +87,124 @@ public:
     self = [super init];
     if(self)
     {
-        shapeObjects_ = [[NSMutableDictionary alloc] init];
+        library_ = new GB2ShapeLibrary();
+        library_->setUserDataFactory(fixtureIdString);
     }
     return self;
 }
 
 -(void) dealloc
 {
-    [shapeObjects_ release];
+    delete library_;
     [super dealloc];
 }
 
+-(GB2ShapeLibrary*) library
+{
+    return library_;
+}
+
 -(void) addFixturesToBody:(b2Body*)body forShapeName:(NSString*)shape
 {
-    BodyDef *so = [shapeObjects_ objectForKey:shape];
+    library_->addFixturesToBody(body, [shape UTF8String]);
+}
+
+-(void) addFixturesToBody:(b2Body*)body forShapeName:(NSString*)shape scale:(float)scale
+{
+    library_->addFixturesToBody(body, [shape UTF8String], scale);
+}
+
+-(int) addFixturesToBody:(b2Body*)body forShapeName:(NSString*)shape scale:(float)scale lod:(GB2ShapeLOD)lod
+{
+    return library_->addFixturesToBody(body, [shape UTF8String], scale, lod);
+}
+
+-(void) iterateFixturesForShapeName:(NSString*)shape withBlock:(GB2FixtureDefCallBack)callback
+{
+    const GB2ShapeDef *so = library_->shape([shape UTF8String]);
     assert(so);
     
-    FixtureDef *fix = so->fixtures;
-    while(fix)
+    for(GB2ShapeFixture *fix = so->fixtures; fix; fix = fix->next)
     {
-        body->CreateFixture(&fix->fixture);
-        fix = fix->next;
+        callback(&fix->fixture);
     }
 }
 
 -(CGPoint) anchorPointForShape:(NSString*)shape
 {
-    BodyDef *bd = [shapeObjects_ objectForKey:shape];
+    const GB2ShapeDef *bd = library_->shape([shape UTF8String]);
     assert(bd);
-    return bd->anchorPoint;
+    return CGPointMake(bd->anchorPoint.x, bd->anchorPoint.y);
 }
 
--(void) addShapesWithFile:(NSString*)plist
+-(id) parseShapesWithFile:(NSString*)plist
 {
+    GB2_TRACE_SCOPE("GB2ShapeCache::parseShapesWithFile");
+
     NSString *path = [[NSBundle mainBundle] pathForResource:plist
                                                ofType:nil
                                           inDirectory:nil];
 
-	NSDictionary *dictionary = [NSDictionary dictionaryWithContentsOfFile:path];
-
-    NSDictionary *metadataDict = [dictionary objectForKey:@"metadata"];
-    int format = [[metadataDict objectForKey:@"format"] intValue];
-    ptmRatio_ =  [[metadataDict objectForKey:@"ptm_ratio"] floatValue];
-
-    NSAssert(format == 1, @"Format not supported");
+    NSData *data = [NSData dataWithContentsOfFile:path];
+    NSAssert(data, @"Can't read %@", plist);
     
-    NSDictionary *bodyDict = [dictionary objectForKey:@"bodies"];
-
-    b2Vec2 vertices[b2_maxPolygonVertices];
-
-    for(NSString *bodyName in bodyDict) 
+    // the library reads xml only - convert binary plists
+    if([data length] >= 6 && memcmp([data bytes], "bplist", 6) == 0)
     {
-        // get the body data
-        NSDictionary *bodyData = [bodyDict objectForKey:bodyName];
-
-        // create body object
-        BodyDef *bodyDef = [[[BodyDef alloc] init] autorelease];
+        id propertyList = [NSPropertyListSerialization propertyListWithData:data options:0 format:NULL error:NULL];
+        data = [NSPropertyListSerialization dataWithPropertyList:propertyList
+                                                          format:NSPropertyListXMLFormat_v1_0
+                                                         options:0
+                                                           error:NULL];
+    }
+    
+    GB2ParsedShapes *parsedShapes = [[[GB2ParsedShapes alloc] init] autorelease];
+    parsedShapes->shapeSet = library_->parse((const char*)[data bytes], [data length]);
+    NSAssert(parsedShapes->shapeSet, @"Format not supported");
+    
+    return parsedShapes;
+}
 
-        bodyDef->anchorPoint = CGPointFromString_([bodyData objectForKey:@"anchorpoint"]);
-        
-        // iterate through the fixtures
-        NSArray *fixtureList = [bodyData objectForKey:@"fixtures"];
-        FixtureDef **nextFixtureDef = &(bodyDef->fixtures);
+-(void) addParsedShapes:(id)parsedShapes
+{
+    GB2ParsedShapes *shapes = (GB2ParsedShapes*)parsedShapes;
+    if(shapes->shapeSet)
+    {
+        // the library takes ownership
+        library_->addShapes(shapes->shapeSet);
+        shapes->shapeSet = 0;
+    }
+}
 
-        for(NSDictionary *fixtureData in fixtureList)
-        {
-            b2FixtureDef basicData;
-            
-            basicData.filter.categoryBits = [[fixtureData objectForKey:@"filter_categoryBits"] intValue];
-            basicData.filter.maskBits = [[fixtureData objectForKey:@"filter_maskBits"] intValue];
-            basicData.filter.groupIndex = [[fixtureData objectForKey:@"filter_groupIndex"] intValue];
-            basicData.friction = [[fixtureData objectForKey:@"friction"] floatValue];
-            basicData.density = [[fixtureData objectForKey:@"density"] floatValue];
-            basicData.restitution = [[fixtureData objectForKey:@"restitution"] floatValue];
-            basicData.isSensor = [[fixtureData objectForKey:@"isSensor"] boolValue];
-            basicData.userData = [[fixtureData objectForKey:@"id"] retain];
-            int callbackData = [[fixtureData objectForKey:@"userdataCbValue"] intValue];
-            
-            NSString *fixtureType = [fixtureData objectForKey:@"fixture_type"];
+-(void) addShapesWithFile:(NSString*)plist
+{
+    GB2_TRACE_SCOPE("GB2ShapeCache::addShapesWithFile");
+    [self addParsedShapes:[self parseShapesWithFile:plist]];
+}
 
-            // read polygon fixtures. One convave fixture may consist of several convex polygons
-            if([fixtureType isEqual:@"POLYGON"])
-            {
-                NSArray *polygonsArray = [fixtureData objectForKey:@"polygons"];
-                
-                for(NSArray *polygonArray in polygonsArray)
-                {
-                    FixtureDef *fix = new FixtureDef();
-                    fix->fixture = basicData; // copy basic data
-                    fix->callbackData = callbackData;
+-(float) minExtentForShape:(NSString*)shape
+{
+    const GB2ShapeDef *bd = library_->shape([shape UTF8String]);
+    assert(bd);
+    return bd->minExtent;
+}
 
-                    b2PolygonShape *polyshape = new b2PolygonShape();
-                    int vindex = 0;
-                    
-                    assert([polygonArray count] <= b2_maxPolygonVertices);
-                    for(NSString *pointString in polygonArray)
-                    {
-                        CGPoint offset = CGPointFromString_(pointString);
-                        vertices[vindex].x = (offset.x / ptmRatio_) ; 
-                        vertices[vindex].y = (offset.y / ptmRatio_) ; 
-                        vindex++;
-                    }
-                    
-                    polyshape->Set(vertices, vindex);
-                    fix->fixture.shape = polyshape;
-                    
-                    // create a list
-                    *nextFixtureDef = fix;
-                    nextFixtureDef = &(fix->next);
-                }
-            }
-            else if([fixtureType isEqual:@"CIRCLE"])
-            {
-                FixtureDef *fix = new FixtureDef();
-                fix->fixture = basicData; // copy basic data
-                fix->callbackData = callbackData;
-                
-                NSDictionary *circleData = [fixtureData objectForKey:@"circle"];
-                
-                b2CircleShape *circleShape = new b2CircleShape();
-                circleShape->m_radius = [[circleData objectForKey:@"radius"] floatValue]  / ptmRatio_;
-                CGPoint p = CGPointFromString_([circleData objectForKey:@"position"]);
-                circleShape->m_p = b2Vec2(p.x / ptmRatio_, p.y / ptmRatio_);
-                fix->fixture.shape = circleShape;
+-(void) iterateMemoryUsageWithBlock:(GB2ShapeMemoryCallBack)callback
+{
+    library_->iterateMemoryUsage(^(const std::string &name, int fixtures, size_t bytes) {
+        callback([NSString stringWithUTF8String:name.c_str()], fixtures, bytes);
+    });
+}
 
-                // create a list
-                *nextFixtureDef = fix;
-                nextFixtureDef = &(fix->next);
-            }
-            else
-            {
-                // unknown type
-                assert(0);
-            }
-        }
-     
-        // add the body element to the hash
-        [shapeObjects_ setObject:bodyDef forKey:bodyName];
-    }
+-(size_t) memoryUsage:(int*)fixtures
+{
+    return library_->memoryUsage(fixtures);
 }
 
 -(float) ptmRatio
 {
-    return ptmRatio_;
+    return library_->ptmRatio();
 }
 
 
 @end
-
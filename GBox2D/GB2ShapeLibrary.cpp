@@ -0,0 +1,743 @@
+/*
+ MIT License
+ 
+ Copyright (c) 2010 Andreas Loew / www.code-and-web.de
+ 
+ For more information about htis module visit
+ http://www.PhysicsEditor.de
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <set>
+#include <vector>
+#include "GB2ShapeLibrary.h"
+#include "GB2Plist.h"
+#include "GB2Trace.h"
+
+// scaled shapes are cached in steps of 1/kGB2ScaleQuantization
+static const int kGB2ScaleQuantization = 100;
+
+// number of vertices of the polygon enclosing a circle in coarse shapes
+static const int kGB2CircleVertices = 8;
+
+/**
+ * Default user data: interned fixture id
+ * The strings live until the process ends, equal ids share
+ * the same pointer.
+ */
+static void *internedFixtureId(const char *fixtureId)
+{
+    static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+    static std::set<std::string> *ids = new std::set<std::string>();
+    
+    pthread_mutex_lock(&mutex);
+    const char *interned = ids->insert(fixtureId).first->c_str();
+    pthread_mutex_unlock(&mutex);
+    
+    return (void*)interned;
+}
+
+/**
+ * Parses a point in the format "{ x,y }"
+ */
+static b2Vec2 pointFromString(const GB2PlistValue *value)
+{
+    b2Vec2 p(0.0f, 0.0f);
+    if(!value)
+    {
+        return p;
+    }
+    
+    const char *s = value->string.c_str();
+    while(*s == '{' || *s == ' ')
+    {
+        s++;
+    }
+    char *end;
+    p.x = (float32)strtod(s, &end);
+    s = end;
+    while(*s == ',' || *s == ' ')
+    {
+        s++;
+    }
+    p.y = (float32)strtod(s, 0);
+    return p;
+}
+
+/**
+ * Returns the value of a dictionary, an empty value if the key does not exist
+ */
+static const GB2PlistValue &valueForKey(const GB2PlistValue &dict, const char *key)
+{
+    static const GB2PlistValue none;
+    const GB2PlistValue *value = dict.objectForKey(key);
+    return value ? *value : none;
+}
+
+/**
+ * Returns the smallest width of a polygon or the diameter of a circle
+ */
+static float32 shapeExtent(const b2Shape *shape)
+{
+    if(shape->GetType() == b2Shape::e_circle)
+    {
+        return 2.0f * shape->m_radius;
+    }
+    
+    // smallest width of the convex polygon measured along its edge normals
+    const b2PolygonShape *polyshape = (const b2PolygonShape*)shape;
+    float32 extent = b2_maxFloat;
+    for(int32 i=0; i<polyshape->GetVertexCount(); i++)
+    {
+        const b2Vec2 &normal = polyshape->m_normals[i];
+        float32 d = b2Dot(normal, polyshape->m_vertices[i]);
+        float32 width = 0.0f;
+        for(int32 j=0; j<polyshape->GetVertexCount(); j++)
+        {
+            width = b2Max(width, d - b2Dot(normal, polyshape->m_vertices[j]));
+        }
+        extent = b2Min(extent, width);
+    }
+    return extent;
+}
+
+/**
+ * Returns the smallest extent of all fixtures in the list
+ */
+static float32 fixturesMinExtent(GB2ShapeFixture *fixtures)
+{
+    float32 extent = b2_maxFloat;
+    for(GB2ShapeFixture *fix = fixtures; fix; fix = fix->next)
+    {
+        extent = b2Min(extent, shapeExtent(fix->fixture.shape));
+    }
+    return (extent < b2_maxFloat) ? extent : 0.0f;
+}
+
+/**
+ * Creates a copy of the shape definition with scaled shapes
+ */
+static GB2ShapeDef *scaledShapeDef(const GB2ShapeDef *so, float32 scale)
+{
+    GB2ShapeDef *scaled = new GB2ShapeDef();
+    scaled->anchorPoint = so->anchorPoint;
+    scaled->minExtent = so->minExtent * scale;
+    
+    GB2ShapeFixture **nextFixtureDef = &(scaled->fixtures);
+    for(GB2ShapeFixture *fix = so->fixtures; fix; fix = fix->next)
+    {
+        GB2ShapeFixture *scaledFix = new GB2ShapeFixture();
+        scaledFix->fixture = fix->fixture; // copy basic data
+        scaledFix->callbackData = fix->callbackData;
+        
+        if(fix->fixture.shape->GetType() == b2Shape::e_polygon)
+        {
+            const b2PolygonShape *polyshape = (const b2PolygonShape*)fix->fixture.shape;
+            b2Vec2 vertices[b2_maxPolygonVertices];
+            for(int32 i=0; i<polyshape->GetVertexCount(); i++)
+            {
+                vertices[i] = scale * polyshape->GetVertex(i);
+            }
+            b2PolygonShape *scaledShape = new b2PolygonShape();
+            scaledShape->Set(vertices, polyshape->GetVertexCount());
+            scaledFix->fixture.shape = scaledShape;
+        }
+        else
+        {
+            const b2CircleShape *circleShape = (const b2CircleShape*)fix->fixture.shape;
+            b2CircleShape *scaledShape = new b2CircleShape();
+            scaledShape->m_radius = scale * circleShape->m_radius;
+            scaledShape->m_p = scale * circleShape->m_p;
+            scaledFix->fixture.shape = scaledShape;
+        }
+        
+        // create a list
+        *nextFixtureDef = scaledFix;
+        nextFixtureDef = &(scaledFix->next);
+    }
+    
+    return scaled;
+}
+
+/**
+ * Returns true if two fixtures can be merged into one coarse fixture
+ */
+static bool sameFixtureGroup(const b2FixtureDef &a, const b2FixtureDef &b)
+{
+    return a.userData == b.userData
+        && a.isSensor == b.isSensor
+        && a.filter.categoryBits == b.filter.categoryBits
+        && a.filter.maskBits == b.filter.maskBits
+        && a.filter.groupIndex == b.filter.groupIndex;
+}
+
+/**
+ * Adds the outline of a shape to the points
+ * Circles are replaced by an enclosing polygon with axis aligned edges
+ */
+static void addShapePoints(const b2Shape *shape, std::vector<b2Vec2> &points)
+{
+    if(shape->GetType() == b2Shape::e_circle)
+    {
+        const b2CircleShape *circleShape = (const b2CircleShape*)shape;
+        float32 r = circleShape->m_radius / cosf(b2_pi / kGB2CircleVertices);
+        for(int i=0; i<kGB2CircleVertices; i++)
+        {
+            float32 angle = (i + 0.5f) * 2.0f * b2_pi / kGB2CircleVertices;
+            points.push_back(circleShape->m_p + r * b2Vec2(cosf(angle), sinf(angle)));
+        }
+        return;
+    }
+    
+    const b2PolygonShape *polyshape = (const b2PolygonShape*)shape;
+    for(int32 i=0; i<polyshape->GetVertexCount(); i++)
+    {
+        points.push_back(polyshape->GetVertex(i));
+    }
+}
+
+static bool lessPoint(const b2Vec2 &a, const b2Vec2 &b)
+{
+    return (a.x < b.x) || (a.x == b.x && a.y < b.y);
+}
+
+/**
+ * Convex hull of the points in counter clockwise order
+ * Monotone chain, collinear points are dropped
+ */
+static void convexHull(std::vector<b2Vec2> points, std::vector<b2Vec2> &hull)
+{
+    std::sort(points.begin(), points.end(), lessPoint);
+    hull.clear();
+    if(points.size() < 3)
+    {
+        return;
+    }
+    
+    hull.resize(2 * points.size());
+    size_t k = 0;
+    for(size_t i=0; i<points.size(); i++)
+    {
+        while(k >= 2 && b2Cross(hull[k-1] - hull[k-2], points[i] - hull[k-2]) <= 0.0f)
+        {
+            k--;
+        }
+        hull[k++] = points[i];
+    }
+    for(size_t i=points.size()-1, lower=k+1; i>0; i--)
+    {
+        while(k >= lower && b2Cross(hull[k-1] - hull[k-2], points[i-1] - hull[k-2]) <= 0.0f)
+        {
+            k--;
+        }
+        hull[k++] = points[i-1];
+    }
+    hull.resize(k - 1);
+}
+
+/**
+ * Reduces a convex polygon to at most maxVertices vertices
+ * Vertices closer than b2_linearSlop are welded, then the vertex
+ * spanning the smallest triangle with its neighbours is removed
+ * until the polygon fits.
+ */
+static void reduceHull(std::vector<b2Vec2> &hull, size_t maxVertices)
+{
+    for(size_t i=0; hull.size() > 2 && i < hull.size(); )
+    {
+        const b2Vec2 &next = hull[(i + 1) % hull.size()];
+        if(b2DistanceSquared(hull[i], next) < b2_linearSlop * b2_linearSlop)
+        {
+            hull.erase(hull.begin() + (i + 1) % hull.size());
+        }
+        else
+        {
+            i++;
+        }
+    }
+    
+    while(hull.size() > maxVertices)
+    {
+        size_t n = hull.size();
+        size_t smallest = 0;
+        float32 smallestArea = b2_maxFloat;
+        for(size_t i=0; i<n; i++)
+        {
+            const b2Vec2 &prev = hull[(i + n - 1) % n];
+            const b2Vec2 &next = hull[(i + 1) % n];
+            float32 area = b2Cross(hull[i] - prev, next - prev);
+            if(area < smallestArea)
+            {
+                smallestArea = area;
+                smallest = i;
+            }
+        }
+        hull.erase(hull.begin() + smallest);
+    }
+}
+
+/**
+ * Creates one coarse shape covering all fixtures of a group
+ * Degenerated hulls fall back to the bounding circle.
+ */
+static b2Shape *coarseShape(const std::vector<const GB2ShapeFixture*> &group, GB2ShapeLOD lod)
+{
+    std::vector<b2Vec2> points;
+    for(size_t i=0; i<group.size(); i++)
+    {
+        addShapePoints(group[i]->fixture.shape, points);
+    }
+    
+    b2Vec2 lower = points[0];
+    b2Vec2 upper = points[0];
+    for(size_t i=1; i<points.size(); i++)
+    {
+        lower = b2Min(lower, points[i]);
+        upper = b2Max(upper, points[i]);
+    }
+    b2Vec2 center = 0.5f * (lower + upper);
+    
+    if(lod == kGB2ShapeLODHull)
+    {
+        std::vector<b2Vec2> hull;
+        convexHull(points, hull);
+        reduceHull(hull, b2_maxPolygonVertices);
+        if(hull.size() >= 3)
+        {
+            b2PolygonShape *polyshape = new b2PolygonShape();
+            polyshape->Set(&hull[0], (int32)hull.size());
+            return polyshape;
+        }
+        lod = kGB2ShapeLODCircle;
+    }
+    
+    if(lod == kGB2ShapeLODBox)
+    {
+        b2Vec2 extents = b2Max(0.5f * (upper - lower), b2Vec2(b2_linearSlop, b2_linearSlop));
+        b2PolygonShape *polyshape = new b2PolygonShape();
+        polyshape->SetAsBox(extents.x, extents.y, center, 0.0f);
+        return polyshape;
+    }
+    
+    // bounding circle around the center of the box, exact for circles
+    float32 radius = b2_linearSlop;
+    for(size_t i=0; i<group.size(); i++)
+    {
+        const b2Shape *shape = group[i]->fixture.shape;
+        if(shape->GetType() == b2Shape::e_circle)
+        {
+            const b2CircleShape *circleShape = (const b2CircleShape*)shape;
+            radius = b2Max(radius, b2Distance(center, circleShape->m_p) + circleShape->m_radius);
+        }
+        else
+        {
+            const b2PolygonShape *polyshape = (const b2PolygonShape*)shape;
+            for(int32 j=0; j<polyshape->GetVertexCount(); j++)
+            {
+                radius = b2Max(radius, b2Distance(center, polyshape->GetVertex(j)));
+            }
+        }
+    }
+    b2CircleShape *circleShape = new b2CircleShape();
+    circleShape->m_p = center;
+    circleShape->m_radius = radius;
+    return circleShape;
+}
+
+/**
+ * Creates a coarse copy of the shape definition
+ * Fixtures with the same filter, sensor flag and user data are merged.
+ */
+static GB2ShapeDef *coarseShapeDef(const GB2ShapeDef *so, GB2ShapeLOD lod)
+{
+    std::vector< std::vector<const GB2ShapeFixture*> > groups;
+    for(GB2ShapeFixture *fix = so->fixtures; fix; fix = fix->next)
+    {
+        size_t g = 0;
+        while(g < groups.size() && !sameFixtureGroup(groups[g][0]->fixture, fix->fixture))
+        {
+            g++;
+        }
+        if(g == groups.size())
+        {
+            groups.push_back(std::vector<const GB2ShapeFixture*>());
+        }
+        groups[g].push_back(fix);
+    }
+    
+    GB2ShapeDef *coarse = new GB2ShapeDef();
+    coarse->anchorPoint = so->anchorPoint;
+    
+    GB2ShapeFixture **nextFixtureDef = &(coarse->fixtures);
+    for(size_t g=0; g<groups.size(); g++)
+    {
+        GB2ShapeFixture *coarseFix = new GB2ShapeFixture();
+        coarseFix->fixture = groups[g][0]->fixture; // copy basic data
+        coarseFix->callbackData = groups[g][0]->callbackData;
+        coarseFix->fixture.shape = coarseShape(groups[g], lod);
+        
+        // create a list
+        *nextFixtureDef = coarseFix;
+        nextFixtureDef = &(coarseFix->next);
+    }
+    
+    coarse->minExtent = fixturesMinExtent(coarse->fixtures);
+    return coarse;
+}
+
+/**
+ * Deletes all shape definitions of a map
+ */
+static void deleteShapes(std::map<std::string, GB2ShapeDef*> &shapes)
+{
+    std::map<std::string, GB2ShapeDef*>::iterator it;
+    for(it = shapes.begin(); it != shapes.end(); ++it)
+    {
+        delete it->second;
+    }
+    shapes.clear();
+}
+
+GB2ShapeSet::~GB2ShapeSet()
+{
+    deleteShapes(shapes);
+}
+
+GB2ShapeLibrary::GB2ShapeLibrary()
+: ptm(0.0f)
+, userDataFactory(internedFixtureId)
+{
+}
+
+GB2ShapeLibrary::~GB2ShapeLibrary()
+{
+    deleteShapes(shapes);
+    deleteShapes(scaledShapes);
+}
+
+void GB2ShapeLibrary::setUserDataFactory(UserDataFactory factory)
+{
+    userDataFactory = factory ? factory : internedFixtureId;
+}
+
+GB2ShapeSet *GB2ShapeLibrary::parse(const char *data, size_t size) const
+{
+    GB2_TRACE_SCOPE("GB2ShapeLibrary::parse");
+    
+    GB2PlistValue dictionary;
+    if(!GB2ParsePlist(data, size, dictionary))
+    {
+        return 0;
+    }
+    
+    const GB2PlistValue &metadataDict = valueForKey(dictionary, "metadata");
+    int format = valueForKey(metadataDict, "format").intValue();
+    float32 ptmRatio = valueForKey(metadataDict, "ptm_ratio").floatValue();
+    if(format != 1 || ptmRatio <= 0.0f)
+    {
+        // format not supported
+        return 0;
+    }
+    
+    GB2ShapeSet *shapeSet = new GB2ShapeSet();
+    shapeSet->ptmRatio = ptmRatio;
+    
+    const GB2PlistValue &bodyDict = valueForKey(dictionary, "bodies");
+    
+    b2Vec2 vertices[b2_maxPolygonVertices];
+    
+    for(size_t bodyIndex=0; bodyIndex<bodyDict.count(); bodyIndex++)
+    {
+        // get the body data
+        const GB2PlistValue &bodyData = bodyDict.objectAtIndex(bodyIndex);
+        
+        // create body object
+        GB2ShapeDef *shapeDef = new GB2ShapeDef();
+        
+        shapeDef->anchorPoint = pointFromString(bodyData.objectForKey("anchorpoint"));
+        
+        // iterate through the fixtures
+        const GB2PlistValue &fixtureList = valueForKey(bodyData, "fixtures");
+        GB2ShapeFixture **nextFixtureDef = &(shapeDef->fixtures);
+        
+        for(size_t fixtureIndex=0; fixtureIndex<fixtureList.count(); fixtureIndex++)
+        {
+            const GB2PlistValue &fixtureData = fixtureList.objectAtIndex(fixtureIndex);
+            b2FixtureDef basicData;
+            
+            basicData.filter.categoryBits = valueForKey(fixtureData, "filter_categoryBits").intValue();
+            basicData.filter.maskBits = valueForKey(fixtureData, "filter_maskBits").intValue();
+            basicData.filter.groupIndex = valueForKey(fixtureData, "filter_groupIndex").intValue();
+            basicData.friction = valueForKey(fixtureData, "friction").floatValue();
+            basicData.density = valueForKey(fixtureData, "density").floatValue();
+            basicData.restitution = valueForKey(fixtureData, "restitution").floatValue();
+            basicData.isSensor = valueForKey(fixtureData, "isSensor").boolValue();
+            
+            const GB2PlistValue *fixtureId = fixtureData.objectForKey("id");
+            basicData.userData = fixtureId ? userDataFactory(fixtureId->string.c_str()) : 0;
+            int callbackData = valueForKey(fixtureData, "userdataCbValue").intValue();
+            
+            const std::string &fixtureType = valueForKey(fixtureData, "fixture_type").string;
+            
+            // read polygon fixtures. One convave fixture may consist of several convex polygons
+            if(fixtureType == "POLYGON")
+            {
+                const GB2PlistValue &polygonsArray = valueForKey(fixtureData, "polygons");
+                
+                for(size_t polygonIndex=0; polygonIndex<polygonsArray.count(); polygonIndex++)
+                {
+                    const GB2PlistValue &polygonArray = polygonsArray.objectAtIndex(polygonIndex);
+                    
+                    GB2ShapeFixture *fix = new GB2ShapeFixture();
+                    fix->fixture = basicData; // copy basic data
+                    fix->callbackData = callbackData;
+                    
+                    b2PolygonShape *polyshape = new b2PolygonShape();
+                    int32 vindex = 0;
+                    
+                    b2Assert(polygonArray.count() <= b2_maxPolygonVertices);
+                    for(size_t i=0; i<polygonArray.count(); i++)
+                    {
+                        b2Vec2 offset = pointFromString(&polygonArray.objectAtIndex(i));
+                        vertices[vindex].x = (offset.x / ptmRatio) ;
+                        vertices[vindex].y = (offset.y / ptmRatio) ;
+                        vindex++;
+                    }
+                    
+                    polyshape->Set(vertices, vindex);
+                    fix->fixture.shape = polyshape;
+                    
+                    // create a list
+                    *nextFixtureDef = fix;
+                    nextFixtureDef = &(fix->next);
+                }
+            }
+            else if(fixtureType == "CIRCLE")
+            {
+                GB2ShapeFixture *fix = new GB2ShapeFixture();
+                fix->fixture = basicData; // copy basic data
+                fix->callbackData = callbackData;
+                
+                const GB2PlistValue &circleData = valueForKey(fixtureData, "circle");
+                
+                b2CircleShape *circleShape = new b2CircleShape();
+                circleShape->m_radius = valueForKey(circleData, "radius").floatValue() / ptmRatio;
+                b2Vec2 p = pointFromString(circleData.objectForKey("position"));
+                circleShape->m_p = b2Vec2(p.x / ptmRatio, p.y / ptmRatio);
+                fix->fixture.shape = circleShape;
+                
+                // create a list
+                *nextFixtureDef = fix;
+                nextFixtureDef = &(fix->next);
+            }
+            else
+            {
+                // unknown type
+                b2Assert(0);
+            }
+        }
+        
+        shapeDef->minExtent = fixturesMinExtent(shapeDef->fixtures);
+        
+        // add the body element to the set, a later body replaces an earlier one
+        GB2ShapeDef *&entry = shapeSet->shapes[bodyDict.keyAtIndex(bodyIndex)];
+        delete entry;
+        entry = shapeDef;
+    }
+    
+    return shapeSet;
+}
+
+void GB2ShapeLibrary::addShapes(GB2ShapeSet *shapeSet)
+{
+    ptm = shapeSet->ptmRatio;
+    
+    std::map<std::string, GB2ShapeDef*>::iterator it;
+    for(it = shapeSet->shapes.begin(); it != shapeSet->shapes.end(); ++it)
+    {
+        GB2ShapeDef *&entry = shapes[it->first];
+        delete entry;
+        entry = it->second;
+    }
+    shapeSet->shapes.clear();
+    delete shapeSet;
+    
+    // scaled shapes might be outdated now
+    deleteShapes(scaledShapes);
+}
+
+bool GB2ShapeLibrary::addShapesWithData(const char *data, size_t size)
+{
+    GB2ShapeSet *shapeSet = parse(data, size);
+    if(!shapeSet)
+    {
+        return false;
+    }
+    addShapes(shapeSet);
+    return true;
+}
+
+bool GB2ShapeLibrary::addShapesWithFile(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if(!file)
+    {
+        return false;
+    }
+    
+    std::vector<char> data;
+    char buffer[4096];
+    size_t bytesRead;
+    while((bytesRead = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    {
+        data.insert(data.end(), buffer, buffer + bytesRead);
+    }
+    fclose(file);
+    
+    return !data.empty() && addShapesWithData(&data[0], data.size());
+}
+
+const GB2ShapeDef *GB2ShapeLibrary::shape(const std::string &name) const
+{
+    std::map<std::string, GB2ShapeDef*>::const_iterator it = shapes.find(name);
+    return (it != shapes.end()) ? it->second : 0;
+}
+
+int GB2ShapeLibrary::quantizeScale(float32 scale)
+{
+    // a zero scale would collapse the polygons
+    return std::max((int)lroundf(scale * kGB2ScaleQuantization), 1);
+}
+
+const GB2ShapeDef *GB2ShapeLibrary::scaledShape(const std::string &name, float32 scale)
+{
+    int quantizedScale = quantizeScale(scale);
+    if(quantizedScale == kGB2ScaleQuantization)
+    {
+        return shape(name);
+    }
+    
+    char suffix[16];
+    snprintf(suffix, sizeof(suffix), "@%d", quantizedScale);
+    std::string key = name + suffix;
+    
+    std::map<std::string, GB2ShapeDef*>::iterator it = scaledShapes.find(key);
+    if(it != scaledShapes.end())
+    {
+        return it->second;
+    }
+    
+    const GB2ShapeDef *original = shape(name);
+    if(!original)
+    {
+        return 0;
+    }
+    GB2ShapeDef *so = scaledShapeDef(original, (float32)quantizedScale / kGB2ScaleQuantization);
+    scaledShapes[key] = so;
+    return so;
+}
+
+const GB2ShapeDef *GB2ShapeLibrary::lodShape(const std::string &name, float32 scale, GB2ShapeLOD lod)
+{
+    const GB2ShapeDef *scaled = scaledShape(name, scale);
+    if(lod == kGB2ShapeLODFull || !scaled)
+    {
+        return scaled;
+    }
+    b2Assert(lod < kGB2ShapeLODLevels);
+    
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), "@%d#%d", quantizeScale(scale), (int)lod);
+    std::string key = name + suffix;
+    
+    std::map<std::string, GB2ShapeDef*>::iterator it = scaledShapes.find(key);
+    if(it != scaledShapes.end())
+    {
+        return it->second;
+    }
+    
+    GB2ShapeDef *so = coarseShapeDef(scaled, lod);
+    scaledShapes[key] = so;
+    return so;
+}
+
+int GB2ShapeLibrary::addFixturesToBody(b2Body *body, const std::string &name, float32 scale, GB2ShapeLOD lod)
+{
+    const GB2ShapeDef *so = lodShape(name, scale, lod);
+    b2Assert(so);
+    
+    int count = 0;
+    for(GB2ShapeFixture *fix = so->fixtures; fix; fix = fix->next)
+    {
+        body->CreateFixture(&fix->fixture);
+        count++;
+    }
+    return count;
+}
+
+size_t GB2ShapeLibrary::shapeMemoryUsage(const std::string &name, const GB2ShapeDef *shapeDef, int *fixtures)
+{
+    size_t bytes = sizeof(GB2ShapeDef) + name.capacity();
+    *fixtures = 0;
+    for(GB2ShapeFixture *fix = shapeDef->fixtures; fix; fix = fix->next)
+    {
+        bytes += sizeof(GB2ShapeFixture);
+        bytes += (fix->fixture.shape->GetType() == b2Shape::e_circle) ? sizeof(b2CircleShape) : sizeof(b2PolygonShape);
+        (*fixtures)++;
+    }
+    return bytes;
+}
+
+/**
+ * Sums up the memory usage of the shapes
+ */
+struct GB2ShapeMemorySum
+{
+    GB2ShapeMemorySum(size_t *aBytes, int *aFixtures)
+    : bytes(aBytes)
+    , fixtures(aFixtures)
+    {}
+    
+    void operator()(const std::string &, int numFixtures, size_t numBytes)
+    {
+        *bytes += numBytes;
+        *fixtures += numFixtures;
+    }
+    
+    size_t *bytes;
+    int *fixtures;
+};
+
+size_t GB2ShapeLibrary::memoryUsage(int *fixtures) const
+{
+    size_t totalBytes = 0;
+    int totalFixtures = 0;
+    iterateMemoryUsage(GB2ShapeMemorySum(&totalBytes, &totalFixtures));
+    if(fixtures)
+    {
+        *fixtures = totalFixtures;
+    }
+    return totalBytes;
+}
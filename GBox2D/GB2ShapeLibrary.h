@@ -0,0 +1,243 @@
+/*
+ MIT License
+ 
+ Copyright (c) 2010 Andreas Loew / www.code-and-web.de
+ 
+ For more information about htis module visit
+ http://www.PhysicsEditor.de
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#include <map>
+#include <string>
+#include "Box2D.h"
+
+#pragma once
+
+/**
+ * Fixture definition of a shape
+ * Holds the fixture and the PhysicsEditor callback value,
+ * fixtures of a shape are stored as a list
+ */
+class GB2ShapeFixture
+{
+public:
+    GB2ShapeFixture()
+    : next(0)
+    , callbackData(0)
+    {}
+    
+    ~GB2ShapeFixture()
+    {
+        delete next;
+        delete fixture.shape;
+    }
+    
+    GB2ShapeFixture *next;
+    b2FixtureDef fixture;
+    int callbackData;
+};
+
+/**
+ * Shape definition
+ * Holds the fixtures and the anchor point of a shape
+ */
+class GB2ShapeDef
+{
+public:
+    GB2ShapeDef()
+    : fixtures(0)
+    , anchorPoint(0.0f, 0.0f)
+    , minExtent(0.0f)
+    {}
+    
+    ~GB2ShapeDef()
+    {
+        delete fixtures;
+    }
+    
+    GB2ShapeFixture *fixtures;
+    b2Vec2 anchorPoint;         //!< anchor point relative to the sprite size
+    float32 minExtent;          //!< smallest fixture extent in physics coordinates
+};
+
+/**
+ * Result of parsing a shapes file
+ * Holds the shape definitions and the ptm ratio
+ */
+class GB2ShapeSet
+{
+public:
+    GB2ShapeSet()
+    : ptmRatio(0.0f)
+    {}
+    
+    ~GB2ShapeSet();
+    
+    std::map<std::string, GB2ShapeDef*> shapes;
+    float32 ptmRatio;
+};
+
+/**
+ * Level of detail of a shape
+ * Coarser levels replace the fixtures of a shape by fewer and simpler
+ * fixtures. Fixtures with the same filter, sensor flag and user data
+ * are merged into one fixture.
+ */
+enum GB2ShapeLOD
+{
+    kGB2ShapeLODFull = 0,   //!< fixtures as created in PhysicsEditor
+    kGB2ShapeLODHull,       //!< convex hull, reduced to b2_maxPolygonVertices
+    kGB2ShapeLODBox,        //!< axis aligned bounding box
+    kGB2ShapeLODCircle,     //!< bounding circle
+    kGB2ShapeLODLevels
+};
+
+/**
+ * GB2ShapeLibrary
+ *
+ * Portable storage for the shapes created with PhysicsEditor
+ *
+ * Reads the XML plist format without Foundation and can be used
+ * on servers without cocos2d. GB2ShapeCache is the Objective-C
+ * interface on top of it.
+ */
+class GB2ShapeLibrary
+{
+public:
+    /**
+     * Creates the user data of a fixture from the fixture id
+     * The user data is not released by the library.
+     */
+    typedef void *(*UserDataFactory)(const char *fixtureId);
+    
+    GB2ShapeLibrary();
+    ~GB2ShapeLibrary();
+    
+    /**
+     * Sets the factory for the fixture user data
+     * The default factory returns interned C strings
+     */
+    void setUserDataFactory(UserDataFactory factory);
+    
+    /**
+     * Parses a shapes file without adding it to the library
+     * This method does not modify the library and can be called
+     * from a background thread.
+     * @param data xml plist data
+     * @param size size of the data
+     * @return parsed shapes or NULL if the data can't be read,
+     *         add them with addShapes()
+     */
+    GB2ShapeSet *parse(const char *data, size_t size) const;
+    
+    /**
+     * Adds parsed shapes, takes ownership of the shape set
+     * Shapes with the same name are replaced.
+     */
+    void addShapes(GB2ShapeSet *shapeSet);
+    
+    /**
+     * Parses and adds shapes
+     * @return false if the data can't be read
+     */
+    bool addShapesWithData(const char *data, size_t size);
+    bool addShapesWithFile(const char *path);
+    
+    /**
+     * Returns the shape definition, NULL if the shape does not exist
+     */
+    const GB2ShapeDef *shape(const std::string &name) const;
+    
+    /**
+     * Returns the scale in cache steps of 1%, at least 1
+     * Scales with the same value share the scaled shape.
+     */
+    static int quantizeScale(float32 scale);
+    
+    /**
+     * Returns the scaled shape definition
+     * Polygon vertices, circle radius and position are scaled.
+     * The scaled fixtures are created on first use and cached per
+     * shape and scale. The scale is quantized to 1%, scales below
+     * 1% use 1%.
+     * @return shape definition or NULL if the shape does not exist
+     */
+    const GB2ShapeDef *scaledShape(const std::string &name, float32 scale);
+    
+    /**
+     * Returns the scaled shape definition in a level of detail
+     * Coarse levels are created from the scaled shape on first use
+     * and cached like scaled shapes. Density, friction and restitution
+     * of a merged fixture are taken from its first fixture.
+     * @return shape definition or NULL if the shape does not exist
+     */
+    const GB2ShapeDef *lodShape(const std::string &name, float32 scale, GB2ShapeLOD lod);
+    
+    /**
+     * Adds fixtures of a shape to a body
+     * @param body body to add the fixture to
+     * @param name name of the shape
+     * @param scale scale factor
+     * @param lod level of detail
+     * @return number of fixtures added
+     */
+    int addFixturesToBody(b2Body *body, const std::string &name, float32 scale = 1.0f, GB2ShapeLOD lod = kGB2ShapeLODFull);
+    
+    /**
+     * Calls callback(name, fixtures, bytes) with the memory used
+     * by each shape. Scaled variants are reported with their cache
+     * key (name@scale in percent, followed by #lod for coarse levels)
+     */
+    template<class CallBack> void iterateMemoryUsage(CallBack callback) const
+    {
+        const std::map<std::string, GB2ShapeDef*> *maps[2] = { &shapes, &scaledShapes };
+        for(int i=0; i<2; i++)
+        {
+            std::map<std::string, GB2ShapeDef*>::const_iterator it;
+            for(it = maps[i]->begin(); it != maps[i]->end(); ++it)
+            {
+                int fixtures;
+                size_t bytes = shapeMemoryUsage(it->first, it->second, &fixtures);
+                callback(it->first, fixtures, bytes);
+            }
+        }
+    }
+    
+    /**
+     * Returns the memory used by all shapes
+     * @param fixtures receives the number of fixtures, might be NULL
+     * @return size in bytes
+     */
+    size_t memoryUsage(int *fixtures) const;
+    
+    /**
+     * Returns the ptm ratio of the last added shapes
+     */
+    float32 ptmRatio() const { return ptm; }
+    
+private:
+    static size_t shapeMemoryUsage(const std::string &name, const GB2ShapeDef *shapeDef, int *fixtures);
+    
+    std::map<std::string, GB2ShapeDef*> shapes;
+    std::map<std::string, GB2ShapeDef*> scaledShapes;
+    float32 ptm;
+    UserDataFactory userDataFactory;
+};
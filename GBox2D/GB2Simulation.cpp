@@ -0,0 +1,226 @@
+/*
+ MIT License
+ 
+ Copyright (c) 2010 Andreas Loew / www.code-and-web.de
+ 
+ For more information about htis module visit
+ http://www.PhysicsEditor.de
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#include "GB2Simulation.h"
+#include "GB2SolverBudget.h"
+#include "GB2Trace.h"
+
+// default step settings
+static const float32 kGB2TimeStep = 1.0f / 30.0f;
+static const int32 kGB2VelocityIterations = 5;
+static const int32 kGB2PositionIterations = 1;
+
+/**
+ * Internal contact listener
+ * Records the begin and end events and forwards all callbacks
+ */
+class GB2SimulationContactListener : public b2ContactListener
+{
+public:
+    GB2SimulationContactListener(GB2Simulation *aSimulation)
+    : simulation(aSimulation)
+    , listener(0)
+    , record(true)
+    {}
+    
+    void BeginContact(b2Contact *contact)
+    {
+        if(record)
+        {
+            recordEvent(contact, true);
+        }
+        if(listener)
+        {
+            listener->BeginContact(contact);
+        }
+    }
+    
+    void EndContact(b2Contact *contact)
+    {
+        if(record)
+        {
+            recordEvent(contact, false);
+        }
+        if(listener)
+        {
+            listener->EndContact(contact);
+        }
+    }
+    
+    void PreSolve(b2Contact *contact, const b2Manifold *oldManifold)
+    {
+        if(listener)
+        {
+            listener->PreSolve(contact, oldManifold);
+        }
+    }
+    
+    void PostSolve(b2Contact *contact, const b2ContactImpulse *impulse)
+    {
+        if(listener)
+        {
+            listener->PostSolve(contact, impulse);
+        }
+    }
+    
+    GB2Simulation *simulation;
+    b2ContactListener *listener;
+    bool record;
+    
+private:
+    void recordEvent(b2Contact *contact, bool begin)
+    {
+        GB2ContactEvent event;
+        event.fixtureA = contact->GetFixtureA();
+        event.fixtureB = contact->GetFixtureB();
+        event.childIndexA = contact->GetChildIndexA();
+        event.childIndexB = contact->GetChildIndexB();
+        event.begin = begin;
+        simulation->contactEvents.push_back(event);
+    }
+};
+
+GB2Simulation::GB2Simulation(const b2Vec2 &gravity)
+: solverBudget(0)
+, timeStep(kGB2TimeStep)
+, accumulator(0.0f)
+, velocityIterations(kGB2VelocityIterations)
+, positionIterations(kGB2PositionIterations)
+, lastVelocityIterations(kGB2VelocityIterations)
+, lastPositionIterations(kGB2PositionIterations)
+, lastStepTime(0.0f)
+, awakeBodies(0)
+, stepCount(0)
+{
+    world = new b2World(gravity);
+    world->SetAllowSleeping(true);
+    
+    contactListener = new GB2SimulationContactListener(this);
+    world->SetContactListener(contactListener);
+}
+
+GB2Simulation::~GB2Simulation()
+{
+    // the world calls the listener while destroying the bodies
+    world->SetContactListener(NULL);
+    delete world;
+    delete contactListener;
+    delete solverBudget;
+}
+
+void GB2Simulation::setIterations(int32 aVelocityIterations, int32 aPositionIterations)
+{
+    velocityIterations = aVelocityIterations;
+    positionIterations = aPositionIterations;
+}
+
+void GB2Simulation::enableSolverBudget(float32 budget)
+{
+    if(solverBudget)
+    {
+        solverBudget->setBudget(budget);
+    }
+    else
+    {
+        solverBudget = new GB2SolverBudget(budget);
+    }
+}
+
+void GB2Simulation::disableSolverBudget()
+{
+    delete solverBudget;
+    solverBudget = 0;
+}
+
+void GB2Simulation::setContactListener(b2ContactListener *listener)
+{
+    contactListener->listener = listener;
+}
+
+void GB2Simulation::setRecordContactEvents(bool record)
+{
+    contactListener->record = record;
+}
+
+void GB2Simulation::step()
+{
+    int32 vIterations = velocityIterations;
+    int32 pIterations = positionIterations;
+    if(solverBudget)
+    {
+        vIterations = solverBudget->velocityIterations();
+        pIterations = solverBudget->positionIterations();
+    }
+    
+    contactEvents.clear();
+    kinematics.step(timeStep);
+    
+    b2Timer timer;
+    {
+        GB2_TRACE_SCOPE("b2World::Step");
+        world->Step(timeStep, vIterations, pIterations);
+    }
+    lastStepTime = timer.GetMilliseconds();
+    lastVelocityIterations = vIterations;
+    lastPositionIterations = pIterations;
+    stepCount++;
+    
+    awakeBodies = 0;
+    for(b2Body *b = world->GetBodyList(); b; b = b->GetNext())
+    {
+        if(b->IsAwake())
+        {
+            awakeBodies++;
+        }
+    }
+    
+    if(solverBudget)
+    {
+        // awake bodies and contacts are the load of the next step
+        solverBudget->update(lastStepTime, awakeBodies, world->GetContactCount());
+    }
+}
+
+int32 GB2Simulation::advance(float32 dt, int32 maxSteps)
+{
+    accumulator += dt;
+    
+    int32 steps = 0;
+    while(accumulator >= timeStep && steps < maxSteps)
+    {
+        step();
+        accumulator -= timeStep;
+        steps++;
+    }
+    
+    if(accumulator >= timeStep)
+    {
+        // can't catch up - drop the time
+        accumulator = 0.0f;
+    }
+    return steps;
+}
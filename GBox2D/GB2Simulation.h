@@ -0,0 +1,170 @@
+/*
+ MIT License
+ 
+ Copyright (c) 2010 Andreas Loew / www.code-and-web.de
+ 
+ For more information about htis module visit
+ http://www.PhysicsEditor.de
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#include <vector>
+#include "Box2D.h"
+#include "GB2KinematicController.h"
+
+#pragma once
+
+class GB2SolverBudget;
+class GB2SimulationContactListener;
+
+/**
+ * Begin or end of a contact, recorded during a step
+ */
+struct GB2ContactEvent
+{
+    b2Fixture *fixtureA;
+    b2Fixture *fixtureB;
+    int32 childIndexA;
+    int32 childIndexB;
+    bool begin;             //!< true for begin contact, false for end contact
+};
+
+/**
+ * GB2Simulation
+ *
+ * Portable simulation core without cocos2d, GL or Foundation
+ *
+ * Owns the b2World and runs the fixed time step loop. Begin and
+ * end contact events of a step are collected into a batch which
+ * can be processed after the step - the world is unlocked then
+ * and bodies can be created or destroyed. An additional contact
+ * listener receives the callbacks immediately during the step.
+ * Kinematic motions are applied right before each step.
+ *
+ * GB2Engine runs on top of this class, servers can use it
+ * directly together with GB2ShapeLibrary.
+ */
+class GB2Simulation
+{
+public:
+    GB2Simulation(const b2Vec2 &gravity);
+    ~GB2Simulation();
+    
+    /**
+     * Returns the world
+     */
+    b2World *getWorld() const { return world; }
+    
+    /**
+     * Sets the fixed time step in seconds, default is 1/30
+     */
+    void setTimeStep(float32 aTimeStep) { timeStep = aTimeStep; }
+    float32 getTimeStep() const { return timeStep; }
+    
+    /**
+     * Sets the solver iterations used without solver budget
+     * Default is 5 velocity and 1 position iteration
+     */
+    void setIterations(int32 velocityIterations, int32 positionIterations);
+    
+    /**
+     * Adapts the iterations to a time budget per step in ms
+     * Replaces the fixed iterations until the budget is disabled.
+     */
+    void enableSolverBudget(float32 budget);
+    void disableSolverBudget();
+    GB2SolverBudget *getSolverBudget() const { return solverBudget; }
+    
+    /**
+     * Returns the controller for velocity driven kinematic bodies
+     */
+    GB2KinematicController *getKinematics() { return &kinematics; }
+    
+    /**
+     * Sets a listener which receives the contact callbacks
+     * immediately during the step, might be NULL
+     */
+    void setContactListener(b2ContactListener *listener);
+    
+    /**
+     * Enables or disables the recording of contact events
+     * Enabled by default. Disable it if the events are not
+     * used or while bodies are destroyed in bulk.
+     */
+    void setRecordContactEvents(bool record);
+    
+    /**
+     * Returns the contact events since the last clear
+     * The events are cleared at the start of each step. The
+     * fixtures of end events might be destroyed already if
+     * they were recorded while destroying a body.
+     */
+    const std::vector<GB2ContactEvent> &getContactEvents() const { return contactEvents; }
+    void clearContactEvents() { contactEvents.clear(); }
+    
+    /**
+     * Performs one fixed step
+     */
+    void step();
+    
+    /**
+     * Advances the simulation by the elapsed time with fixed steps
+     * The remainder is kept for the next call. At most maxSteps
+     * are performed, the remaining time is dropped then to
+     * prevent a spiral of death.
+     * @param dt elapsed time in seconds
+     * @param maxSteps maximum number of steps
+     * @return number of steps performed
+     */
+    int32 advance(float32 dt, int32 maxSteps = 5);
+    
+    /**
+     * Returns the fraction of a step the accumulated time is ahead
+     * of the world, for interpolation of the rendered state
+     */
+    float32 getInterpolationAlpha() const { return accumulator / timeStep; }
+    
+    /**
+     * Returns the data of the last step
+     */
+    int32 getLastVelocityIterations() const { return lastVelocityIterations; }
+    int32 getLastPositionIterations() const { return lastPositionIterations; }
+    float32 getLastStepTime() const { return lastStepTime; }            //!< ms
+    int32 getAwakeBodyCount() const { return awakeBodies; }
+    uint32 getStepCount() const { return stepCount; }
+    
+private:
+    friend class GB2SimulationContactListener;
+    
+    b2World *world;
+    GB2SimulationContactListener *contactListener;
+    GB2SolverBudget *solverBudget;
+    std::vector<GB2ContactEvent> contactEvents;
+    GB2KinematicController kinematics;
+    float32 timeStep;
+    float32 accumulator;
+    int32 velocityIterations;
+    int32 positionIterations;
+    int32 lastVelocityIterations;
+    int32 lastPositionIterations;
+    float32 lastStepTime;
+    int32 awakeBodies;
+    uint32 stepCount;
+};
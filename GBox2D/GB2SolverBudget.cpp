@@ -0,0 +1,143 @@
+/*
+ MIT License
+ 
+ Copyright (c) 2010 Andreas Loew / www.code-and-web.de
+ 
+ For more information about htis module visit
+ http://www.PhysicsEditor.de
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#include <string.h>
+#include "GB2SolverBudget.h"
+
+// weight of the newest step time in the average
+static const float32 kGB2StepTimeSmoothing = 0.3f;
+
+GB2SolverBudget::GB2SolverBudget(float32 aBudget)
+: budget(aBudget)
+, minVelocityIterations(2)
+, maxVelocityIterations(8)
+, minPositionIterations(1)
+, maxPositionIterations(3)
+, headroomFraction(0.5f)
+, headroomSteps(30)
+, stepsWithHeadroom(0)
+, hasMeasurement(false)
+{
+    memset(&stats, 0, sizeof(stats));
+    
+    // start with the engine's defaults
+    stats.velocityIterations = 5;
+    stats.positionIterations = 1;
+}
+
+void GB2SolverBudget::setBudget(float32 aBudget)
+{
+    budget = aBudget;
+}
+
+void GB2SolverBudget::setVelocityIterationRange(int32 minIterations, int32 maxIterations)
+{
+    b2Assert(minIterations > 0 && minIterations <= maxIterations);
+    minVelocityIterations = minIterations;
+    maxVelocityIterations = maxIterations;
+    stats.velocityIterations = b2Clamp(stats.velocityIterations, minIterations, maxIterations);
+}
+
+void GB2SolverBudget::setPositionIterationRange(int32 minIterations, int32 maxIterations)
+{
+    b2Assert(minIterations >= 0 && minIterations <= maxIterations);
+    minPositionIterations = minIterations;
+    maxPositionIterations = maxIterations;
+    stats.positionIterations = b2Clamp(stats.positionIterations, minIterations, maxIterations);
+}
+
+void GB2SolverBudget::setHeadroom(float32 fraction, int32 steps)
+{
+    headroomFraction = fraction;
+    headroomSteps = steps;
+}
+
+void GB2SolverBudget::update(float32 stepTime, int32 awakeBodies, int32 contacts)
+{
+    // load of the step just measured and of the next step, the load
+    // is unknown before the first measurement and after a sleeping world
+    int32 lastLoad = hasMeasurement ? stats.awakeBodies + stats.contacts : 0;
+    int32 nextLoad = awakeBodies + contacts;
+    
+    stats.lastStepTime = stepTime;
+    if(hasMeasurement)
+    {
+        stats.averageStepTime += kGB2StepTimeSmoothing * (stepTime - stats.averageStepTime);
+    }
+    else
+    {
+        stats.averageStepTime = stepTime;
+        hasMeasurement = true;
+    }
+    stats.awakeBodies = awakeBodies;
+    stats.contacts = contacts;
+    
+    // a spike in the last step is taken as it is, the average
+    // keeps the controller from reacting to single fast steps
+    float32 baseTime = b2Max(stats.averageStepTime, stepTime);
+    stats.predictedStepTime = baseTime;
+    if(lastLoad > 0)
+    {
+        stats.predictedStepTime *= (float32)nextLoad / lastLoad;
+    }
+    
+    if(stats.predictedStepTime > budget)
+    {
+        stepsWithHeadroom = 0;
+        if(stats.velocityIterations > minVelocityIterations)
+        {
+            stats.velocityIterations--;
+            stats.decreases++;
+        }
+        else if(stats.positionIterations > minPositionIterations)
+        {
+            stats.positionIterations--;
+            stats.decreases++;
+        }
+    }
+    else if(stats.predictedStepTime < budget * headroomFraction)
+    {
+        if(++stepsWithHeadroom >= headroomSteps)
+        {
+            stepsWithHeadroom = 0;
+            if(stats.positionIterations < maxPositionIterations)
+            {
+                stats.positionIterations++;
+                stats.increases++;
+            }
+            else if(stats.velocityIterations < maxVelocityIterations)
+            {
+                stats.velocityIterations++;
+                stats.increases++;
+            }
+        }
+    }
+    else
+    {
+        stepsWithHeadroom = 0;
+    }
+}
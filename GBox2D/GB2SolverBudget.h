@@ -0,0 +1,110 @@
+/*
+ MIT License
+ 
+ Copyright (c) 2010 Andreas Loew / www.code-and-web.de
+ 
+ For more information about htis module visit
+ http://www.PhysicsEditor.de
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#include "Box2D.h"
+
+#pragma once
+
+/**
+ * Current decisions and measurements of the GB2SolverBudget
+ */
+struct GB2SolverStats
+{
+    int32 velocityIterations;   //!< velocity iterations used for the next step
+    int32 positionIterations;   //!< position iterations used for the next step
+    float32 lastStepTime;       //!< duration of the last step in ms
+    float32 averageStepTime;    //!< smoothed step duration in ms
+    float32 predictedStepTime;  //!< expected duration of the next step in ms
+    int32 awakeBodies;          //!< awake bodies after the last step
+    int32 contacts;             //!< contacts after the last step
+    int32 decreases;            //!< number of times the iterations were lowered
+    int32 increases;            //!< number of times the iterations were raised
+};
+
+/**
+ * GB2SolverBudget
+ *
+ * Adapts the solver iterations to a time budget per step
+ *
+ * The controller measures the step time and predicts the time of
+ * the next step from the change in awake bodies and contacts.
+ * If the prediction exceeds the budget the velocity iterations are
+ * lowered first, then the position iterations. If there is enough
+ * headroom for some steps the iterations are raised again in the
+ * reverse order.
+ */
+class GB2SolverBudget
+{
+public:
+    GB2SolverBudget(float32 budget);
+    
+    /**
+     * Sets the time budget of a step in milliseconds
+     */
+    void setBudget(float32 budget);
+    
+    /**
+     * Sets the allowed range of the velocity iterations
+     */
+    void setVelocityIterationRange(int32 minIterations, int32 maxIterations);
+    
+    /**
+     * Sets the allowed range of the position iterations
+     */
+    void setPositionIterationRange(int32 minIterations, int32 maxIterations);
+    
+    /**
+     * Sets the fraction of the budget below which the iterations
+     * are raised and the number of steps this must hold
+     */
+    void setHeadroom(float32 fraction, int32 steps);
+    
+    /**
+     * Feeds the measurements of a step and decides the iterations
+     * for the next step
+     * @param stepTime duration of the step in ms
+     * @param awakeBodies number of awake bodies after the step
+     * @param contacts number of contacts after the step
+     */
+    void update(float32 stepTime, int32 awakeBodies, int32 contacts);
+    
+    int32 velocityIterations() const { return stats.velocityIterations; }
+    int32 positionIterations() const { return stats.positionIterations; }
+    const GB2SolverStats &getStats() const { return stats; }
+    
+private:
+    float32 budget;
+    int32 minVelocityIterations;
+    int32 maxVelocityIterations;
+    int32 minPositionIterations;
+    int32 maxPositionIterations;
+    float32 headroomFraction;
+    int32 headroomSteps;
+    int32 stepsWithHeadroom;
+    bool hasMeasurement;
+    GB2SolverStats stats;
+};
@@ -77,12 +77,12 @@
 
 -(void)setDisplayFrame:(CCSpriteFrame *)newFrame
 {
-    [(CCSprite*)self.ccNode setDisplayFrame:newFrame];
+    [self setSpriteDisplayFrame:newFrame];
 }
 
 -(void) setDisplayFrameNamed:(NSString*)name
 {
-    [(CCSprite*)self.ccNode setDisplayFrame:[[CCSpriteFrameCache sharedSpriteFrameCache] spriteFrameByName:name]];
+    [self setSpriteDisplayFrame:[[CCSpriteFrameCache sharedSpriteFrameCache] spriteFrameByName:name]];
 }
 
 @end
@@ -0,0 +1,134 @@
+/*
+ MIT License
+ 
+ Copyright (c) 2010 Andreas Loew / www.code-and-web.de
+ 
+ For more information about htis module visit
+ http://www.PhysicsEditor.de
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import <map>
+#import "cocos2d.h"
+#import "Box2D.h"
+#import "GB2Node.h"
+
+#pragma once
+
+/**
+ * GB2StaticGeometry
+ *
+ * A single static body holding merged level geometry
+ * Created by GB2StaticGeometryBuilder
+ *
+ * Contact callbacks are sent to this object (class
+ * GB2StaticGeometry). Use objectForFixture:inContact: to
+ * get the logical object the fixture was created for.
+ */
+@interface GB2StaticGeometry : GB2Node
+{
+@private
+    std::map<std::pair<b2Fixture*, int32>, id> objects;  //!< logical objects per fixture child
+}
+
+/**
+ * Returns the logical object for a fixture child
+ * Chain fixtures have one child per edge, all other fixtures
+ * have only child 0.
+ * @param fixture fixture of this object
+ * @param childIndex child index of the fixture
+ * @return logical object passed to the builder
+ */
+-(id) objectForFixture:(b2Fixture*)fixture childIndex:(int32)childIndex;
+
+/**
+ * Returns the logical object for a fixture in a contact
+ * The child index is taken from the contact
+ * @param fixture fixture of this object, fixture A or B of the contact
+ * @param contact the box2d contact
+ * @return logical object passed to the builder
+ */
+-(id) objectForFixture:(b2Fixture*)fixture inContact:(b2Contact*)contact;
+
+@end
+
+
+struct GB2StaticGeometryData;
+
+/**
+ * GB2StaticGeometryBuilder
+ *
+ * Merges static level geometry into a single static body
+ *
+ * Shapes from the shape cache are added with a transform,
+ * edges are joined into chain shapes. Identical and degenerate
+ * polygons are dropped, collinear edges of the same object
+ * are merged.
+ *
+ * Each shape and edge can be tagged with a logical object
+ * which is retained and can be queried from the contact
+ * callbacks using the GB2StaticGeometry.
+ */
+@interface GB2StaticGeometryBuilder : NSObject
+{
+@private
+    GB2StaticGeometryData *data;        //!< the collected geometry
+    NSMutableArray *retainedObjects;    //!< keeps the logical objects alive
+    b2FixtureDef edgeFixtureDef;
+    int droppedPolygons;
+}
+
+/**
+ * Fixture definition used for the edge chains
+ * The shape is ignored
+ */
+@property (nonatomic, assign) b2FixtureDef edgeFixtureDef;
+
+/**
+ * Number of polygons dropped as duplicates or degenerated
+ * during the last build
+ */
+@property (nonatomic, readonly) int droppedPolygons;
+
+/**
+ * Adds all fixtures of a shape from the shape cache
+ * @param shape name of the shape
+ * @param pos position in physics coordinates
+ * @param angle angle of the shape
+ * @param object logical object, might be nil
+ */
+-(void) addShape:(NSString*)shape position:(b2Vec2)pos angle:(float)angle object:(id)object;
+
+/**
+ * Adds an edge segment
+ * @param start start point in physics coordinates
+ * @param end end point in physics coordinates
+ * @param object logical object, might be nil
+ */
+-(void) addEdgeFrom:(b2Vec2)start to:(b2Vec2)end object:(id)object;
+
+/**
+ * Creates the static body with all geometry added so far
+ * The builder is empty afterwards.
+ * @return the static geometry object, autoreleased
+ */
+-(GB2StaticGeometry*) build;
+
+@end
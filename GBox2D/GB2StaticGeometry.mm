@@ -0,0 +1,500 @@
+/*
+ MIT License
+ 
+ Copyright (c) 2010 Andreas Loew / www.code-and-web.de
+ 
+ For more information about htis module visit
+ http://www.PhysicsEditor.de
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import <vector>
+#import <map>
+#import "GB2StaticGeometry.h"
+#import "GB2ShapeCache.h"
+#import "GB2Engine.h"
+
+// tolerance in meters for welding vertices and comparing polygons
+static const float32 kGB2WeldTolerance = 0.0001f;
+
+/**
+ * Internal storage of the builder's geometry
+ */
+struct GB2StaticGeometryData
+{
+    struct Polygon
+    {
+        b2FixtureDef fixture;
+        b2Vec2 vertices[b2_maxPolygonVertices];
+        int32 count;
+        id object;
+    };
+    
+    struct Circle
+    {
+        b2FixtureDef fixture;
+        b2Vec2 center;
+        float32 radius;
+        id object;
+    };
+    
+    struct Edge
+    {
+        b2Vec2 a;
+        b2Vec2 b;
+        id object;
+    };
+    
+    std::vector<Polygon> polygons;
+    std::vector<Circle> circles;
+    std::vector<Edge> edges;
+};
+
+typedef std::pair<int32, int32> GB2VertexKey;
+
+/**
+ * Returns the welding grid cell of a vertex
+ */
+static GB2VertexKey vertexKey(const b2Vec2 &v)
+{
+    return GB2VertexKey((int32)floorf(v.x / kGB2WeldTolerance + 0.5f),
+                        (int32)floorf(v.y / kGB2WeldTolerance + 0.5f));
+}
+
+/**
+ * Returns true if both vertices are welded together
+ */
+static bool sameVertex(const b2Vec2 &a, const b2Vec2 &b)
+{
+    return b2Abs(a.x - b.x) <= kGB2WeldTolerance && b2Abs(a.y - b.y) <= kGB2WeldTolerance;
+}
+
+/**
+ * Returns true if a, b, c lie on a line with b between a and c
+ */
+static bool collinear(const b2Vec2 &a, const b2Vec2 &b, const b2Vec2 &c)
+{
+    b2Vec2 ab = b - a;
+    b2Vec2 bc = c - b;
+    return b2Abs(b2Cross(ab, bc)) <= kGB2WeldTolerance * (ab.Length() + bc.Length())
+        && b2Dot(ab, bc) > 0.0f;
+}
+
+/**
+ * Returns true if the fixtures have the same material and filter
+ */
+static bool sameMaterial(const b2FixtureDef &a, const b2FixtureDef &b)
+{
+    return a.friction == b.friction
+        && a.restitution == b.restitution
+        && a.density == b.density
+        && a.isSensor == b.isSensor
+        && a.userData == b.userData
+        && a.filter.categoryBits == b.filter.categoryBits
+        && a.filter.maskBits == b.filter.maskBits
+        && a.filter.groupIndex == b.filter.groupIndex;
+}
+
+/**
+ * Rotates the vertex list so that it starts with the
+ * lowest vertex - identical polygons get the same order
+ */
+static void canonicalizePolygon(GB2StaticGeometryData::Polygon &p)
+{
+    int32 first = 0;
+    for(int32 i=1; i<p.count; i++)
+    {
+        const b2Vec2 &v = p.vertices[i];
+        const b2Vec2 &f = p.vertices[first];
+        if(v.x < f.x - kGB2WeldTolerance || (v.x <= f.x + kGB2WeldTolerance && v.y < f.y))
+        {
+            first = i;
+        }
+    }
+    
+    b2Vec2 tmp[b2_maxPolygonVertices];
+    for(int32 i=0; i<p.count; i++)
+    {
+        tmp[i] = p.vertices[(first + i) % p.count];
+    }
+    for(int32 i=0; i<p.count; i++)
+    {
+        p.vertices[i] = tmp[i];
+    }
+}
+
+/**
+ * Returns true if the polygon has no area
+ */
+static bool degeneratePolygon(const GB2StaticGeometryData::Polygon &p)
+{
+    float32 area = 0.0f;
+    for(int32 i=1; i+1<p.count; i++)
+    {
+        area += b2Cross(p.vertices[i] - p.vertices[0], p.vertices[i+1] - p.vertices[0]);
+    }
+    return b2Abs(area) <= b2_linearSlop * b2_linearSlop;
+}
+
+/**
+ * Returns true if both polygons are identical
+ */
+static bool samePolygon(const GB2StaticGeometryData::Polygon &a, const GB2StaticGeometryData::Polygon &b)
+{
+    if(a.count != b.count || !sameMaterial(a.fixture, b.fixture))
+    {
+        return false;
+    }
+    for(int32 i=0; i<a.count; i++)
+    {
+        if(!sameVertex(a.vertices[i], b.vertices[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+@interface GB2StaticGeometry (private_selectors)
+- (void)addObject:(id)object forFixture:(b2Fixture*)fixture childIndex:(int32)childIndex;
+@end
+
+@implementation GB2StaticGeometry
+
+-(void) addObject:(id)object forFixture:(b2Fixture*)fixture childIndex:(int32)childIndex
+{
+    if(object)
+    {
+        objects[std::make_pair(fixture, childIndex)] = [object retain];
+    }
+}
+
+-(id) objectForFixture:(b2Fixture*)fixture childIndex:(int32)childIndex
+{
+    std::map<std::pair<b2Fixture*, int32>, id>::const_iterator it = objects.find(std::make_pair(fixture, childIndex));
+    return (it != objects.end()) ? it->second : nil;
+}
+
+-(id) objectForFixture:(b2Fixture*)fixture inContact:(b2Contact*)contact
+{
+    int32 childIndex = (contact->GetFixtureA() == fixture) ? contact->GetChildIndexA() : contact->GetChildIndexB();
+    return [self objectForFixture:fixture childIndex:childIndex];
+}
+
+-(void) dealloc
+{
+    std::map<std::pair<b2Fixture*, int32>, id>::iterator it;
+    for(it = objects.begin(); it != objects.end(); ++it)
+    {
+        [it->second release];
+    }
+    [super dealloc];
+}
+
+@end
+
+
+@interface GB2StaticGeometryBuilder (private_selectors)
+- (void)buildPolygons:(GB2StaticGeometry*)geometry;
+- (void)buildCircles:(GB2StaticGeometry*)geometry;
+- (void)buildChains:(GB2StaticGeometry*)geometry;
+@end
+
+@implementation GB2StaticGeometryBuilder
+
+@synthesize edgeFixtureDef;
+@synthesize droppedPolygons;
+
+-(id) init
+{
+    self = [super init];
+    if(self)
+    {
+        data = new GB2StaticGeometryData();
+        retainedObjects = [[NSMutableArray alloc] init];
+    }
+    return self;
+}
+
+-(void) dealloc
+{
+    delete data;
+    [retainedObjects release];
+    [super dealloc];
+}
+
+-(void) retainObject:(id)object
+{
+    if(object)
+    {
+        [retainedObjects addObject:object];
+    }
+}
+
+-(void) addShape:(NSString*)shape position:(b2Vec2)pos angle:(float)angle object:(id)object
+{
+    [self retainObject:object];
+    
+    b2Transform xf(pos, b2Rot(angle));
+    GB2StaticGeometryData *d = data;
+    
+    [[GB2ShapeCache sharedShapeCache] iterateFixturesForShapeName:shape withBlock:^(const b2FixtureDef *fixtureDef) {
+        if(fixtureDef->shape->GetType() == b2Shape::e_polygon)
+        {
+            const b2PolygonShape *polygon = (const b2PolygonShape*)fixtureDef->shape;
+            GB2StaticGeometryData::Polygon p;
+            p.fixture = *fixtureDef;
+            p.fixture.shape = 0;
+            p.count = polygon->GetVertexCount();
+            for(int32 i=0; i<p.count; i++)
+            {
+                p.vertices[i] = b2Mul(xf, polygon->GetVertex(i));
+            }
+            p.object = object;
+            d->polygons.push_back(p);
+        }
+        else if(fixtureDef->shape->GetType() == b2Shape::e_circle)
+        {
+            const b2CircleShape *circle = (const b2CircleShape*)fixtureDef->shape;
+            GB2StaticGeometryData::Circle c;
+            c.fixture = *fixtureDef;
+            c.fixture.shape = 0;
+            c.center = b2Mul(xf, circle->m_p);
+            c.radius = circle->m_radius;
+            c.object = object;
+            d->circles.push_back(c);
+        }
+    }];
+}
+
+-(void) addEdgeFrom:(b2Vec2)start to:(b2Vec2)end object:(id)object
+{
+    // box2d can't handle edges shorter than the slop
+    if(b2DistanceSquared(start, end) <= b2_linearSlop * b2_linearSlop)
+    {
+        return;
+    }
+    
+    [self retainObject:object];
+    
+    GB2StaticGeometryData::Edge e;
+    e.a = start;
+    e.b = end;
+    e.object = object;
+    data->edges.push_back(e);
+}
+
+-(GB2StaticGeometry*) build
+{
+    GB2StaticGeometry *geometry = [[[GB2StaticGeometry alloc] initWithStaticBody:nil node:nil] autorelease];
+    
+    droppedPolygons = 0;
+    [self buildPolygons:geometry];
+    [self buildCircles:geometry];
+    [self buildChains:geometry];
+    
+    // the geometry object retains the logical objects now
+    delete data;
+    data = new GB2StaticGeometryData();
+    [retainedObjects removeAllObjects];
+    
+    return geometry;
+}
+
+-(void) buildPolygons:(GB2StaticGeometry*)geometry
+{
+    // polygons bucketed by their first vertex to find duplicates
+    std::multimap<GB2VertexKey, size_t> buckets;
+    
+    for(size_t i=0; i<data->polygons.size(); i++)
+    {
+        GB2StaticGeometryData::Polygon &p = data->polygons[i];
+        if(degeneratePolygon(p))
+        {
+            droppedPolygons++;
+            continue;
+        }
+        
+        canonicalizePolygon(p);
+        GB2VertexKey key = vertexKey(p.vertices[0]);
+        
+        bool duplicate = false;
+        std::pair<std::multimap<GB2VertexKey, size_t>::iterator, std::multimap<GB2VertexKey, size_t>::iterator> range = buckets.equal_range(key);
+        for(std::multimap<GB2VertexKey, size_t>::iterator it = range.first; it != range.second; ++it)
+        {
+            if(samePolygon(data->polygons[it->second], p))
+            {
+                duplicate = true;
+                break;
+            }
+        }
+        if(duplicate)
+        {
+            droppedPolygons++;
+            continue;
+        }
+        buckets.insert(std::make_pair(key, i));
+        
+        b2PolygonShape shape;
+        shape.Set(p.vertices, p.count);
+        b2FixtureDef fixtureDef = p.fixture;
+        fixtureDef.shape = &shape;
+        b2Fixture *fixture = [geometry addFixture:&fixtureDef];
+        [geometry addObject:p.object forFixture:fixture childIndex:0];
+    }
+}
+
+-(void) buildCircles:(GB2StaticGeometry*)geometry
+{
+    for(size_t i=0; i<data->circles.size(); i++)
+    {
+        const GB2StaticGeometryData::Circle &c = data->circles[i];
+        b2CircleShape shape;
+        shape.m_p = c.center;
+        shape.m_radius = c.radius;
+        b2FixtureDef fixtureDef = c.fixture;
+        fixtureDef.shape = &shape;
+        b2Fixture *fixture = [geometry addFixture:&fixtureDef];
+        [geometry addObject:c.object forFixture:fixture childIndex:0];
+    }
+}
+
+-(void) buildChains:(GB2StaticGeometry*)geometry
+{
+    std::vector<GB2StaticGeometryData::Edge> &edges = data->edges;
+    
+    // edges connected to each vertex
+    std::multimap<GB2VertexKey, size_t> edgesAtVertex;
+    for(size_t i=0; i<edges.size(); i++)
+    {
+        edgesAtVertex.insert(std::make_pair(vertexKey(edges[i].a), i));
+        edgesAtVertex.insert(std::make_pair(vertexKey(edges[i].b), i));
+    }
+    
+    std::vector<bool> used(edges.size(), false);
+    
+    for(size_t start=0; start<edges.size(); start++)
+    {
+        if(used[start])
+        {
+            continue;
+        }
+        used[start] = true;
+        
+        // walk in both directions from the start edge as long as
+        // the chain continues with exactly one unused edge
+        std::vector<b2Vec2> points[2];
+        std::vector<id> objects[2];
+        bool loop = false;
+        for(int dir=0; dir<2 && !loop; dir++)
+        {
+            b2Vec2 p = dir ? edges[start].a : edges[start].b;
+            for(;;)
+            {
+                GB2VertexKey key = vertexKey(p);
+                if(edgesAtVertex.count(key) != 2)
+                {
+                    break;
+                }
+                
+                std::multimap<GB2VertexKey, size_t>::iterator it = edgesAtVertex.find(key);
+                size_t next = used[it->second] ? (++it)->second : it->second;
+                if(used[next])
+                {
+                    // back at the start edge
+                    loop = (dir == 0) && (key == vertexKey(edges[start].a));
+                    break;
+                }
+                used[next] = true;
+                
+                const GB2StaticGeometryData::Edge &e = edges[next];
+                p = (key == vertexKey(e.a)) ? e.b : e.a;
+                points[dir].push_back(p);
+                objects[dir].push_back(e.object);
+            }
+        }
+        
+        // combine: reversed backward walk, start edge, forward walk
+        std::vector<b2Vec2> chain;
+        std::vector<id> chainObjects;
+        for(size_t i=points[1].size(); i>0; i--)
+        {
+            chain.push_back(points[1][i-1]);
+            chainObjects.push_back(objects[1][i-1]);
+        }
+        chain.push_back(edges[start].a);
+        chain.push_back(edges[start].b);
+        chainObjects.push_back(edges[start].object);
+        chain.insert(chain.end(), points[0].begin(), points[0].end());
+        chainObjects.insert(chainObjects.end(), objects[0].begin(), objects[0].end());
+        
+        if(loop)
+        {
+            // the last point is the start point again
+            chain.pop_back();
+        }
+        
+        // merge collinear edges belonging to the same object
+        std::vector<b2Vec2> merged;
+        std::vector<id> mergedObjects;
+        merged.push_back(chain[0]);
+        for(size_t i=1; i+1<chain.size(); i++)
+        {
+            if(!(collinear(merged.back(), chain[i], chain[i+1]) && chainObjects[i-1] == chainObjects[i]))
+            {
+                merged.push_back(chain[i]);
+                mergedObjects.push_back(chainObjects[i-1]);
+            }
+        }
+        merged.push_back(chain.back());
+        mergedObjects.push_back(chainObjects[chain.size()-2]);
+        if(loop)
+        {
+            // closing edge
+            mergedObjects.push_back(chainObjects.back());
+        }
+        
+        b2ChainShape shape;
+        if(loop && merged.size() >= 3)
+        {
+            shape.CreateLoop(&merged[0], (int32)merged.size());
+        }
+        else
+        {
+            if(loop)
+            {
+                // too small for a loop - close it as a chain
+                merged.push_back(merged[0]);
+            }
+            shape.CreateChain(&merged[0], (int32)merged.size());
+        }
+        
+        b2FixtureDef fixtureDef = edgeFixtureDef;
+        fixtureDef.shape = &shape;
+        b2Fixture *fixture = [geometry addFixture:&fixtureDef];
+        for(int32 i=0; i<(int32)mergedObjects.size() && i<shape.GetChildCount(); i++)
+        {
+            [geometry addObject:mergedObjects[i] forFixture:fixture childIndex:i];
+        }
+    }
+}
+
+@end
@@ -0,0 +1,129 @@
+/*
+ MIT License
+ 
+ Copyright (c) 2010 Andreas Loew / www.code-and-web.de
+ 
+ For more information about htis module visit
+ http://www.PhysicsEditor.de
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+#import <map>
+#import <vector>
+#import "Box2D.h"
+
+#pragma once
+
+@class GB2Node;
+
+/**
+ * Object touching another object
+ */
+struct GB2TouchingNode
+{
+    GB2Node *node;          //!< the touching object
+    int32 contacts;         //!< number of touching fixture contacts
+};
+
+/**
+ * GB2TouchingCache
+ *
+ * Touching state of the objects, updated from the begin and end
+ * contacts of the world's contact listener
+ *
+ * For each object the cache keeps small lists with the touching
+ * objects, the classes of the touching objects (including their
+ * super classes up to GB2Node) and its own fixture ids with a
+ * touching contact. Sensor contacts count as touching, also if
+ * the sensor contacts are batched by GB2SensorOverlaps. The class
+ * lists are built once per class and reused for each contact.
+ *
+ * Destroying a body ends its contacts, which removes it from
+ * the lists of the other objects.
+ */
+class GB2TouchingCache
+{
+public:
+    /**
+     * Updates the touching state from a contact
+     */
+    void beginContact(b2Contact *contact);
+    void endContact(b2Contact *contact);
+    
+    /**
+     * Removes a destroyed object
+     */
+    void removeNode(GB2Node *node);
+    
+    /**
+     * Drops the touching state of all objects
+     */
+    void clear();
+    
+    /**
+     * Adds the touching contacts of a world, used when the cache
+     * is attached to a running world
+     */
+    void addTouchingContacts(b2World *world);
+    
+    /**
+     * Returns the objects touching the object, NULL if no
+     * object touches it
+     */
+    const std::vector<GB2TouchingNode> *touchingNodes(GB2Node *node) const;
+    
+    /**
+     * Returns true if an object of the class or a subclass
+     * touches the object
+     */
+    bool isTouchingClass(GB2Node *node, Class cls) const;
+    
+    /**
+     * Returns true if a fixture with the id touches another object
+     */
+    bool isTouchingFixtureId(GB2Node *node, NSString *fixtureId) const;
+    
+private:
+    /**
+     * Contact count of a class or fixture id
+     */
+    struct Counter
+    {
+        const void *key;
+        int32 contacts;
+    };
+    
+    struct Touching
+    {
+        std::vector<GB2TouchingNode> nodes;
+        std::vector<Counter> classes;
+        std::vector<Counter> fixtureIds;
+    };
+    
+    void update(b2Contact *contact, int32 delta);
+    void change(GB2Node *node, b2Fixture *fixture, GB2Node *other, int32 delta);
+    const std::vector<Class> &classesOf(Class cls);
+    static void count(std::vector<Counter> &counters, const void *key, int32 delta);
+    static bool contains(const std::vector<Counter> &counters, const void *key);
+    
+    std::map<GB2Node*, Touching> touching;
+    std::map<Class, std::vector<Class> > ancestors;     //!< class and its super classes up to GB2Node
+};
@@ -0,0 +1,223 @@
+/*
+ MIT License
+ 
+ Copyright (c) 2010 Andreas Loew / www.code-and-web.de
+ 
+ For more information about htis module visit
+ http://www.PhysicsEditor.de
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import "GB2TouchingCache.h"
+#import "GB2Node.h"
+
+void GB2TouchingCache::beginContact(b2Contact *contact)
+{
+    update(contact, 1);
+}
+
+void GB2TouchingCache::endContact(b2Contact *contact)
+{
+    update(contact, -1);
+}
+
+void GB2TouchingCache::update(b2Contact *contact, int32 delta)
+{
+    b2Fixture *fixtureA = contact->GetFixtureA();
+    b2Fixture *fixtureB = contact->GetFixtureB();
+    GB2Node *a = (GB2Node *)fixtureA->GetBody()->GetUserData();
+    GB2Node *b = (GB2Node *)fixtureB->GetBody()->GetUserData();
+    if(!a || !b)
+    {
+        return;
+    }
+    
+    change(a, fixtureA, b, delta);
+    change(b, fixtureB, a, delta);
+}
+
+void GB2TouchingCache::change(GB2Node *node, b2Fixture *fixture, GB2Node *other, int32 delta)
+{
+    std::map<GB2Node*, Touching>::iterator it = touching.find(node);
+    if(it == touching.end())
+    {
+        if(delta < 0)
+        {
+            // the contact began before the cache was cleared
+            return;
+        }
+        it = touching.insert(std::make_pair(node, Touching())).first;
+    }
+    Touching &state = it->second;
+    
+    // find the object - the lists are small, a linear search is fast
+    size_t i = 0;
+    while(i < state.nodes.size() && state.nodes[i].node != other)
+    {
+        i++;
+    }
+    
+    if(i == state.nodes.size())
+    {
+        if(delta < 0)
+        {
+            return;
+        }
+        GB2TouchingNode touchingNode = { other, 0 };
+        state.nodes.push_back(touchingNode);
+    }
+    
+    state.nodes[i].contacts += delta;
+    if(state.nodes[i].contacts <= 0)
+    {
+        state.nodes[i] = state.nodes.back();
+        state.nodes.pop_back();
+    }
+    
+    // count the class and its super classes so that queries are a lookup
+    const std::vector<Class> &classes = classesOf([other class]);
+    for(size_t c=0; c<classes.size(); c++)
+    {
+        count(state.classes, classes[c], delta);
+    }
+    
+    if(fixture->GetUserData())
+    {
+        count(state.fixtureIds, fixture->GetUserData(), delta);
+    }
+    
+    if(state.nodes.empty())
+    {
+        touching.erase(it);
+    }
+}
+
+const std::vector<Class> &GB2TouchingCache::classesOf(Class cls)
+{
+    std::map<Class, std::vector<Class> >::iterator it = ancestors.find(cls);
+    if(it != ancestors.end())
+    {
+        return it->second;
+    }
+    
+    std::vector<Class> &classes = ancestors[cls];
+    Class rootClass = [GB2Node class];
+    for(Class c = cls; c; c = [c superclass])
+    {
+        classes.push_back(c);
+        if(c == rootClass)
+        {
+            break;
+        }
+    }
+    return classes;
+}
+
+void GB2TouchingCache::count(std::vector<Counter> &counters, const void *key, int32 delta)
+{
+    for(size_t i=0; i<counters.size(); i++)
+    {
+        if(counters[i].key == key)
+        {
+            counters[i].contacts += delta;
+            if(counters[i].contacts <= 0)
+            {
+                counters[i] = counters.back();
+                counters.pop_back();
+            }
+            return;
+        }
+    }
+    
+    if(delta > 0)
+    {
+        Counter counter = { key, delta };
+        counters.push_back(counter);
+    }
+}
+
+bool GB2TouchingCache::contains(const std::vector<Counter> &counters, const void *key)
+{
+    for(size_t i=0; i<counters.size(); i++)
+    {
+        if(counters[i].key == key)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void GB2TouchingCache::removeNode(GB2Node *node)
+{
+    touching.erase(node);
+}
+
+void GB2TouchingCache::clear()
+{
+    touching.clear();
+}
+
+void GB2TouchingCache::addTouchingContacts(b2World *world)
+{
+    for(b2Contact *contact = world->GetContactList(); contact; contact = contact->GetNext())
+    {
+        if(contact->IsTouching())
+        {
+            update(contact, 1);
+        }
+    }
+}
+
+const std::vector<GB2TouchingNode> *GB2TouchingCache::touchingNodes(GB2Node *node) const
+{
+    std::map<GB2Node*, Touching>::const_iterator it = touching.find(node);
+    return (it != touching.end()) ? &it->second.nodes : 0;
+}
+
+bool GB2TouchingCache::isTouchingClass(GB2Node *node, Class cls) const
+{
+    std::map<GB2Node*, Touching>::const_iterator it = touching.find(node);
+    return (it != touching.end()) && contains(it->second.classes, cls);
+}
+
+bool GB2TouchingCache::isTouchingFixtureId(GB2Node *node, NSString *fixtureId) const
+{
+    std::map<GB2Node*, Touching>::const_iterator it = touching.find(node);
+    if(it == touching.end())
+    {
+        return false;
+    }
+    
+    // fixture ids of the shape cache are shared, equal strings are the fallback
+    const std::vector<Counter> &fixtureIds = it->second.fixtureIds;
+    if(contains(fixtureIds, fixtureId))
+    {
+        return true;
+    }
+    for(size_t i=0; i<fixtureIds.size(); i++)
+    {
+        if([(NSString*)fixtureIds[i].key isEqualToString:fixtureId])
+        {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,218 @@
+/*
+ MIT License
+ 
+ Copyright (c) 2010 Andreas Loew / www.code-and-web.de
+ 
+ For more information about htis module visit
+ http://www.PhysicsEditor.de
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+#include <vector>
+#include "GB2Trace.h"
+
+#if defined(__APPLE__)
+#   include <mach/mach_time.h>
+#endif
+
+// number of events kept per thread
+static const uint32_t kGB2TraceCapacity = 16384;
+
+/**
+ * Internal ring buffer of a thread
+ * Only the owning thread writes, head is published after
+ * the event was written.
+ */
+struct GB2TraceBuffer
+{
+    struct Event
+    {
+        const char *name;
+        uint64_t start;
+        uint64_t end;
+    };
+    
+    GB2TraceBuffer(uint32_t aThreadId)
+    : head(0)
+    , threadId(aThreadId)
+    {}
+    
+    Event events[kGB2TraceCapacity];
+    volatile uint32_t head;     //!< number of events written so far
+    uint32_t threadId;
+};
+
+volatile bool GB2Trace::enabled = false;
+
+/**
+ * Full memory barrier, orders the event data before the head
+ */
+static inline void traceMemoryBarrier()
+{
+    __sync_synchronize();
+}
+
+/**
+ * Returns the length of a trace tick in microseconds
+ */
+static double traceTickInMicroseconds()
+{
+#if defined(__APPLE__)
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+    return (double)timebase.numer / (double)timebase.denom / 1000.0;
+#else
+    return 1.0 / 1000.0;
+#endif
+}
+
+static pthread_key_t traceBufferKey;
+static pthread_once_t traceBufferKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_mutex_t traceBuffersMutex = PTHREAD_MUTEX_INITIALIZER;
+static std::vector<GB2TraceBuffer*> traceBuffers;
+
+static void createTraceBufferKey()
+{
+    // buffers are kept after the thread exits so that
+    // their events can still be exported
+    pthread_key_create(&traceBufferKey, 0);
+}
+
+/**
+ * Returns the buffer of the current thread
+ * The buffer is created and registered on first use
+ */
+static GB2TraceBuffer *threadTraceBuffer()
+{
+    pthread_once(&traceBufferKeyOnce, createTraceBufferKey);
+    GB2TraceBuffer *buffer = (GB2TraceBuffer*)pthread_getspecific(traceBufferKey);
+    if(!buffer)
+    {
+        pthread_mutex_lock(&traceBuffersMutex);
+        buffer = new GB2TraceBuffer((uint32_t)traceBuffers.size() + 1);
+        traceBuffers.push_back(buffer);
+        pthread_mutex_unlock(&traceBuffersMutex);
+        pthread_setspecific(traceBufferKey, buffer);
+    }
+    return buffer;
+}
+
+void GB2Trace::setEnabled(bool isEnabled)
+{
+    enabled = isEnabled;
+}
+
+uint64_t GB2Trace::now()
+{
+#if defined(__APPLE__)
+    return mach_absolute_time();
+#else
+    // nanoseconds
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+void GB2Trace::record(const char *name, uint64_t start, uint64_t end)
+{
+    GB2TraceBuffer *buffer = threadTraceBuffer();
+    GB2TraceBuffer::Event &event = buffer->events[buffer->head % kGB2TraceCapacity];
+    event.name = name;
+    event.start = start;
+    event.end = end;
+    
+    // publish the event
+    traceMemoryBarrier();
+    buffer->head++;
+}
+
+std::string GB2Trace::exportJSON()
+{
+    bool wasEnabled = enabled;
+    enabled = false;
+    traceMemoryBarrier();
+    
+    double ticksToMicroseconds = traceTickInMicroseconds();
+    
+    std::string json = "{\"traceEvents\":[";
+    bool first = true;
+    char line[256];
+    
+    std::vector<GB2TraceBuffer::Event> events;
+    
+    pthread_mutex_lock(&traceBuffersMutex);
+    for(size_t b=0; b<traceBuffers.size(); b++)
+    {
+        // scopes opened before the export was started still record -
+        // copy the events, then drop the ones the writer reached meanwhile
+        const GB2TraceBuffer *buffer = traceBuffers[b];
+        uint32_t head = buffer->head;
+        traceMemoryBarrier();
+        uint32_t count = (head < kGB2TraceCapacity) ? head : kGB2TraceCapacity;
+        events.assign(count, GB2TraceBuffer::Event());
+        for(uint32_t i=0; i<count; i++)
+        {
+            events[i] = buffer->events[(head - count + i) % kGB2TraceCapacity];
+        }
+        traceMemoryBarrier();
+        
+        // the writer might be writing the slot of event headAfter, which
+        // holds event headAfter - capacity - older events are intact
+        uint32_t headAfter = buffer->head;
+        for(uint32_t i=0; i<count; i++)
+        {
+            if(headAfter - (head - count + i) >= kGB2TraceCapacity)
+            {
+                continue;
+            }
+            
+            const GB2TraceBuffer::Event &event = events[i];
+            snprintf(line, sizeof(line),
+                     "%s\n{\"name\":\"%s\",\"cat\":\"physics\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+                     first ? "" : ",",
+                     event.name,
+                     event.start * ticksToMicroseconds,
+                     (event.end - event.start) * ticksToMicroseconds,
+                     buffer->threadId);
+            json += line;
+            first = false;
+        }
+    }
+    pthread_mutex_unlock(&traceBuffersMutex);
+    
+    json += "\n]}\n";
+    
+    enabled = wasEnabled;
+    return json;
+}
+
+void GB2Trace::clear()
+{
+    pthread_mutex_lock(&traceBuffersMutex);
+    for(size_t b=0; b<traceBuffers.size(); b++)
+    {
+        traceBuffers[b]->head = 0;
+    }
+    pthread_mutex_unlock(&traceBuffersMutex);
+}
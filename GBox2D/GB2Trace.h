@@ -0,0 +1,123 @@
+/*
+ MIT License
+ 
+ Copyright (c) 2010 Andreas Loew / www.code-and-web.de
+ 
+ For more information about htis module visit
+ http://www.PhysicsEditor.de
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <string>
+#include "GB2Config.h"
+
+#pragma once
+
+/**
+ * GB2Trace
+ *
+ * Timeline tracing of the physics frames
+ *
+ * Scopes marked with GB2_TRACE_SCOPE("name") are recorded into
+ * a ring buffer per thread. Each thread only writes to its own
+ * buffer, so recording needs no locks. The events can be exported
+ * as Chrome trace event JSON which opens in chrome://tracing
+ * and Perfetto.
+ *
+ * The markers are only compiled in with GB2_TRACE set to 1 in
+ * GB2Config.h and only record while tracing is enabled.
+ */
+class GB2Trace
+{
+public:
+    /**
+     * Enables or disables recording
+     */
+    static void setEnabled(bool enabled);
+    
+    /**
+     * Returns true if recording is enabled
+     */
+    static inline bool isEnabled() { return enabled; }
+    
+    /**
+     * Returns the current time in trace ticks
+     */
+    static uint64_t now();
+    
+    /**
+     * Records a finished scope for the current thread
+     * @param name static string with the scope name
+     * @param start start time in ticks
+     * @param end end time in ticks
+     */
+    static void record(const char *name, uint64_t start, uint64_t end);
+    
+    /**
+     * Exports the recorded events of all threads as Chrome
+     * trace event JSON
+     * Recording is paused during the export. Scopes which were open
+     * when the export started still record, events they overwrite
+     * in the ring buffer during the export are left out.
+     * @return JSON document
+     */
+    static std::string exportJSON();
+    
+    /**
+     * Drops all recorded events
+     */
+    static void clear();
+    
+private:
+    static volatile bool enabled;
+};
+
+/**
+ * Records the lifetime of the scope it is declared in
+ */
+class GB2TraceScope
+{
+public:
+    GB2TraceScope(const char *aName)
+    : name(aName)
+    , start(GB2Trace::isEnabled() ? GB2Trace::now() : 0)
+    {}
+    
+    ~GB2TraceScope()
+    {
+        if(start && GB2Trace::isEnabled())
+        {
+            GB2Trace::record(name, start, GB2Trace::now());
+        }
+    }
+    
+private:
+    const char *name;
+    uint64_t start;
+};
+
+#if GB2_TRACE
+#   define GB2_TRACE_CONCAT_(a, b) a##b
+#   define GB2_TRACE_CONCAT(a, b) GB2_TRACE_CONCAT_(a, b)
+#   define GB2_TRACE_SCOPE(name) GB2TraceScope GB2_TRACE_CONCAT(gb2TraceScope, __LINE__)(name)
+#else
+#   define GB2_TRACE_SCOPE(name)
+#endif
@@ -31,6 +31,10 @@
 
 #pragma once
 
+class GB2ContactStats;
+class GB2SensorOverlaps;
+class GB2TouchingCache;
+
 /**
  * GB2WorldContactListener
  *
@@ -64,7 +68,8 @@
  *
  * The functions are called for each contact point. To detect if
  * some objects have contact you need to count the number of 
- * begin and end calls.
+ * begin and end calls - or use the touching state kept by
+ * setTouchingCache(), see GB2TouchingCache.
  *
  * During the presolve phase it is possible to disable collisions
  * e.g. if a player picksup an object you usually don't want him to
@@ -81,6 +86,12 @@
  *   [contact setEnabled:NO];
  * to disable the collition for this contact.
  *
+ * With enableStats() the listener counts the callbacks and their
+ * dispatch time per class pair and fixture id, see GB2ContactStats.
+ *
+ * With setSensorOverlaps() the contacts of sensors implementing
+ * sensorEntered:exited: are collected into overlap sets instead,
+ * see GB2SensorOverlaps.
  */
 class GB2WorldContactListener: public b2ContactListener
 {
@@ -92,5 +103,33 @@ public:
 	virtual void PreSolve(b2Contact* contact, const b2Manifold* oldManifold);
 	virtual void PostSolve(b2Contact* contact, const b2ContactImpulse* impulse);    
     void notifyObjects(b2Contact *contact, NSString *beginOrEnd);
+    
+    /**
+     * Starts counting the contact callbacks
+     * @param windowFrames number of frames in the rolling window
+     */
+    void enableStats(int32 windowFrames);
+    void disableStats();
+    
+    /**
+     * Returns the contact statistics, NULL if disabled
+     */
+    GB2ContactStats *getStats() const { return stats; }
+    
+    /**
+     * Sets the overlap sets for batched sensor contacts, NULL
+     * dispatches all contacts to the objects
+     */
+    void setSensorOverlaps(GB2SensorOverlaps *overlaps) { sensorOverlaps = overlaps; }
+    
+    /**
+     * Sets the touching state updated with the begin and end
+     * contacts, NULL disables the update
+     */
+    void setTouchingCache(GB2TouchingCache *cache) { touchingCache = cache; }
+    
 protected:
+    GB2ContactStats *stats;
+    GB2SensorOverlaps *sensorOverlaps;
+    GB2TouchingCache *touchingCache;
 };
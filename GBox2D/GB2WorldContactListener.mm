@@ -25,17 +25,55 @@
  THE SOFTWARE.
  */
 
+#import <QuartzCore/QuartzCore.h>
 #import "Box2D.h"
 #import "GB2Contact.h"
+#import "GB2ContactStats.h"
+#import "GB2SensorOverlaps.h"
+#import "GB2TouchingCache.h"
 #import "GB2WorldContactListener.h"
+#import "GB2Trace.h"
 
 GB2WorldContactListener::GB2WorldContactListener()
 : b2ContactListener()
+, stats(0)
+, sensorOverlaps(0)
+, touchingCache(0)
 {
 }
 
 GB2WorldContactListener::~GB2WorldContactListener() 
 {
+    delete stats;
+}
+
+void GB2WorldContactListener::enableStats(int32 windowFrames)
+{
+    delete stats;
+    stats = new GB2ContactStats(windowFrames);
+}
+
+void GB2WorldContactListener::disableStats()
+{
+    delete stats;
+    stats = 0;
+}
+
+/**
+ * Notifies the objects and counts the callback if the stats are enabled
+ */
+static inline void notifyAndRecord(GB2WorldContactListener *listener, GB2ContactStats *stats,
+                                   b2Contact *contact, NSString *contactType, GB2ContactEventType type)
+{
+    if(!stats)
+    {
+        listener->notifyObjects(contact, contactType);
+        return;
+    }
+    
+    CFTimeInterval start = CACurrentMediaTime();
+    listener->notifyObjects(contact, contactType);
+    stats->record(type, contact, CACurrentMediaTime() - start);
 }
 
 /**
@@ -120,13 +158,31 @@ void GB2WorldContactListener::notifyObjects(b2Contact *contact, NSString *contac
 /// Called when two fixtures begin to touch.
 void GB2WorldContactListener::BeginContact(b2Contact* contact) 
 {
-    notifyObjects(contact, @"beginContact");        
+    GB2_TRACE_SCOPE("GB2WorldContactListener::beginContact");
+    if(touchingCache)
+    {
+        touchingCache->beginContact(contact);
+    }
+    if(sensorOverlaps && sensorOverlaps->beginContact(contact))
+    {
+        return;
+    }
+    notifyAndRecord(this, stats, contact, @"beginContact", kGB2ContactBegin);
 }
 
 /// Called when two fixtures cease to touch.
 void GB2WorldContactListener::EndContact(b2Contact* contact) 
 { 
-    notifyObjects(contact, @"endContact");
+    GB2_TRACE_SCOPE("GB2WorldContactListener::endContact");
+    if(touchingCache)
+    {
+        touchingCache->endContact(contact);
+    }
+    if(sensorOverlaps && sensorOverlaps->endContact(contact))
+    {
+        return;
+    }
+    notifyAndRecord(this, stats, contact, @"endContact", kGB2ContactEnd);
 }
 
 /// This is called after a contact is updated. This allows you to inspect a
@@ -144,7 +200,8 @@ void GB2WorldContactListener::PreSolve(b2Contact* contact, const b2Manifold* old
     B2_NOT_USED(contact);
     B2_NOT_USED(oldManifold);
 
-    notifyObjects(contact, @"presolveContact");        
+    GB2_TRACE_SCOPE("GB2WorldContactListener::presolveContact");
+    notifyAndRecord(this, stats, contact, @"presolveContact", kGB2ContactPresolve);
 }
 
 /// This lets you inspect a contact after the solver is finished. This is useful
@@ -28,6 +28,7 @@
 #pragma once
 
 #include <stdlib.h>
+#include <stdint.h>
 
 /**
  * Swap two values
@@ -62,6 +63,208 @@ inline float clamp(T v, T min, T max)
     return v;
 }
 
+/**
+ * State of a GRandom stream
+ * Can be stored and restored to replay random sequences
+ */
+struct GRandomState
+{
+    uint32_t s[4];
+};
+
+/**
+ * Fast seedable random number stream (xoshiro128**)
+ *
+ * Each stream is independent - use one stream per world or
+ * system to get reproducible sequences. A stream must not be
+ * used from multiple threads at the same time.
+ */
+class GRandom
+{
+public:
+    /**
+     * Creates a stream with the given seed
+     * @param seed seed value
+     */
+    explicit GRandom(uint32_t seed = 0x9e3779b9u)
+    {
+        setSeed(seed);
+    }
+    
+    /**
+     * Reseeds the stream
+     * The state is expanded from the seed with splitmix32
+     * @param seed seed value
+     */
+    void setSeed(uint32_t seed)
+    {
+        for(int i=0; i<4; i++)
+        {
+            seed += 0x9e3779b9u;
+            uint32_t z = seed;
+            z = (z ^ (z >> 16)) * 0x85ebca6bu;
+            z = (z ^ (z >> 13)) * 0xc2b2ae35u;
+            state.s[i] = z ^ (z >> 16);
+        }
+    }
+    
+    /**
+     * Returns the current state
+     */
+    GRandomState getState() const
+    {
+        return state;
+    }
+    
+    /**
+     * Restores a state returned by getState
+     */
+    void setState(const GRandomState &aState)
+    {
+        state = aState;
+    }
+    
+    /**
+     * Returns the next 32 bit random value
+     */
+    inline uint32_t next()
+    {
+        return nextFromState(state.s);
+    }
+    
+    /**
+     * Returns a random float in [0, 1)
+     */
+    inline float nextFloat()
+    {
+        // use the upper 24 bits as mantissa
+        return (float)(next() >> 8) * (1.0f / 16777216.0f);
+    }
+    
+    /**
+     * Returns a random float in [min, max)
+     * @param min minimum
+     * @param max maximum
+     */
+    inline float floatRange(float min, float max)
+    {
+        if(min > max)
+        {
+            swap(min, max);
+        }
+        return (max-min) * nextFloat() + min;
+    }
+    
+    /**
+     * Returns a random int in [min, max]
+     * @param min minimum
+     * @param max maximum
+     */
+    inline int intRange(int min, int max)
+    {
+        if(min > max)
+        {
+            swap(min, max);
+        }
+        uint32_t range = (uint32_t)max - (uint32_t)min + 1u;
+        if(range == 0)
+        {
+            // full 32 bit range
+            return (int)next();
+        }
+        // multiply-shift maps the value to the range without division
+        return (int)((uint32_t)min + (uint32_t)(((uint64_t)next() * range) >> 32));
+    }
+    
+    /**
+     * Fills an array with random floats in [min, max)
+     * Cheaper than calling floatRange for each value
+     * @param values array to fill
+     * @param count number of values
+     * @param min minimum
+     * @param max maximum
+     */
+    void fillFloats(float *values, int count, float min, float max)
+    {
+        if(min > max)
+        {
+            swap(min, max);
+        }
+        const float scale = (max-min) * (1.0f / 16777216.0f);
+        GRandomState local = state;
+        for(int i=0; i<count; i++)
+        {
+            values[i] = (float)(nextFromState(local.s) >> 8) * scale + min;
+        }
+        state = local;
+    }
+    
+    /**
+     * Fills an array with random ints in [min, max]
+     * @param values array to fill
+     * @param count number of values
+     * @param min minimum
+     * @param max maximum
+     */
+    void fillInts(int *values, int count, int min, int max)
+    {
+        if(min > max)
+        {
+            swap(min, max);
+        }
+        const uint64_t range = (uint64_t)((int64_t)max - (int64_t)min) + 1u;
+        GRandomState local = state;
+        for(int i=0; i<count; i++)
+        {
+            values[i] = (int)((int64_t)min + (int64_t)(((uint64_t)nextFromState(local.s) * range) >> 32));
+        }
+        state = local;
+    }
+    
+private:
+    static inline uint32_t rotl(uint32_t x, int k)
+    {
+        return (x << k) | (x >> (32 - k));
+    }
+    
+    static inline uint32_t nextFromState(uint32_t *s)
+    {
+        const uint32_t result = rotl(s[1] * 5, 7) * 9;
+        const uint32_t t = s[1] << 9;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 11);
+        return result;
+    }
+    
+    GRandomState state;
+};
+
+/**
+ * Returns the default random stream used by gFloatRand
+ * and gRangeRand
+ * The stream is seeded from rand() on first use - seeding with
+ * srand() before that still changes the sequence, as it did when
+ * gFloatRand used rand(). gSeedRand reseeds it at any time.
+ */
+inline GRandom &gDefaultRandom()
+{
+    static GRandom random((uint32_t)rand());
+    return random;
+}
+
+/**
+ * Seeds the default random stream
+ * @param seed seed value
+ */
+inline void gSeedRand(uint32_t seed)
+{
+    gDefaultRandom().setSeed(seed);
+}
+
 /**
  * Floating point ranged random
  * @param min minimum
@@ -70,12 +273,7 @@ inline float clamp(T v, T min, T max)
  */
 inline float gFloatRand(float min, float max)
 {
-    if(min > max)
-    {
-        swap(min, max);
-    }
-    float r = (float)rand() / (float)RAND_MAX;
-    return (max-min) * r + min;
+    return gDefaultRandom().floatRange(min, max);
 }
 
 /**
@@ -90,7 +288,6 @@ inline int gRangeRand(float min, float max)
     {
         swap(min, max);
     }
-    float r = (float)rand() / (float)RAND_MAX;
+    float r = gDefaultRandom().nextFloat();
     return (max-min) * r + min;
 }
-